@@ -0,0 +1,86 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef BAKEDMODEL_H__
+#define BAKEDMODEL_H__
+
+#include "VXLFile.h"
+#include "HVAFile.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/* A VXL model with its HVA animation worked out up front.  For every baked
+ * frame it holds each limb's complete transform (what VoxelRenderer would
+ * multiply in for the limb, including the scaled HVA translation and the
+ * move to the limb's bounding box) and the model space bounding box of all
+ * the voxels.  It can also hold every voxel's centre already transformed,
+ * one array per frame.
+ *
+ * Frames are baked at stepsPerFrame times the HVA frame rate, sampled with
+ * HVAFile::sampleAll, so a loop played back from here costs lookups only
+ */
+class BakedModel {
+public:
+	struct Voxel {
+		uint8_t x, y, z;
+		uint8_t colour;
+		uint8_t normal;
+	};
+protected:
+	uint32_t frames;
+	uint32_t steps;
+	uint32_t limbs;
+	size_t totalVoxels;
+
+	/* 16 floats per limb per frame, frame-major */
+	std::vector<float> transforms;
+	/* min x, y, z then max x, y, z per frame */
+	std::vector<float> bounds;
+	/* Every limb's voxels, limbVoxels[limb] is the first of each */
+	std::vector<Voxel> voxels;
+	std::vector<size_t> limbVoxels;
+	/* Voxel to limb space scale of each limb */
+	std::vector<float> sectionScale;
+	/* 3 floats per voxel per frame, frame-major, empty unless asked for */
+	std::vector<float> centres;
+
+	void bakeTransforms(VXLFile&, HVAFile*);
+	void bakeBounds();
+	void bakeCentres();
+public:
+	BakedModel(VXLFile&, HVAFile*, uint32_t stepsPerFrame = 1, bool withCentres = false);
+
+	uint32_t numFrames() const { return frames; }
+	uint32_t numLimbs() const { return limbs; }
+	/* Baked frame to show at a fractional HVA frame time, wrapping around */
+	uint32_t getFrame(float) const;
+
+	float const* getTransform(uint32_t frame, uint32_t limb) const { return &transforms[(frame * limbs + limb) * 16]; }
+	/* min[3] followed by max[3] */
+	float const* getBounds(uint32_t frame) const { return &bounds[frame * 6]; }
+	float const* getSectionScale(uint32_t limb) const { return &sectionScale[limb * 3]; }
+	Voxel const* getVoxels(uint32_t limb, size_t& n) const;
+	/* NULL if the centres weren't baked or the limb has no voxels */
+	float const* getCentres(uint32_t frame, uint32_t limb) const;
+	size_t bakedSize() const;
+};
+
+#endif
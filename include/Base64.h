@@ -25,20 +25,41 @@
 #include "INIFile.h"
 
 class Base64 {
+public:
+	static int const Scalar;
+	static int const SSSE3;
+	static int const AVX2;
 protected:
+	typedef size_t (*BlockDecoder)(uint8_t const*, uint8_t*, size_t);
+	typedef size_t (*BlockEncoder)(uint8_t const*, uint8_t*, size_t);
+
 	static uint8_t alphabet[64];
 	static uint8_t lookup[256];
+	static uint8_t strictLookup[256];
+	static int implementation;
+	static BlockDecoder blockDecoder;
+	static BlockEncoder blockEncoder;
 
 	static unsigned int decode64Chunk(uint8_t const*, uint8_t*);
+	static size_t decodeBlocksScalar(uint8_t const*, uint8_t*, size_t);
+	static unsigned int decodeQuads(uint8_t const*, uint8_t*, size_t);
+	static void initialise();
+	static void selectImplementation(int);
 	static void initialiseTable();
 	Base64() { }
 	~Base64() { }
 public:
+	static bool isSupported(int);
+	static void setImplementation(int);
+	static int getImplementation();
+
 	static size_t decode(uint8_t* inout, size_t len) {
 		return decode(inout, inout, len);
 	}
 	static size_t decode(uint8_t const*, uint8_t*, size_t);
 	static uint8_t* decode(INIFile&, size_t&);
+	static size_t encodedSize(size_t);
+	static size_t encode(uint8_t const*, size_t, uint8_t*);
 };
 
 #endif
@@ -23,6 +23,7 @@
 #include "Utils.h"
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 class HVAFile {
 public:
@@ -47,13 +48,49 @@ protected:
 	Section* sections;
 
 	uint32_t currentSection;
+
+	/* Every keyframe as a ready GL matrix, frame by frame with the sections in
+	 * file order inside each
+	 */
+	std::vector<float> glMatrices;
+	void buildGLMatrices();
+
+	/* Every keyframe decomposed into rotation quaternion, translation and
+	 * per-axis scale, along with the slerp angle to the next frame.  Laid out
+	 * frame by frame, field by field, with keyStride (numSections rounded up
+	 * to 4) floats per field so sampleAll can blend 4 sections at once
+	 */
+	std::vector<float> keys;
+	uint32_t keyStride;
+	void buildKeys();
+	float const* getKeys(uint32_t frame) const { return &keys[frame * numKeyFields * keyStride]; }
+	uint32_t splitTime(float, float&) const;
 public:
+	static uint32_t const numKeyFields;
+
 	HVAFile(std::string const&);
 	~HVAFile();
 
 	void loadGLMatrix(uint32_t, float*);
+	/* The GL matrix of a section at a frame, or all numSections() of them for
+	 * a frame, without range checks
+	 */
+	float const* getGLMatrix(uint32_t frame, uint32_t section) const { return &glMatrices[(frame * header.numSections + section) * 16]; }
+	float const* getGLMatrices(uint32_t frame) const { return &glMatrices[frame * header.numSections * 16]; }
 	void setCurrentSection(std::string const&);
+	uint32_t findSection(std::string const&) const;
+	uint32_t getCurrentSection() const { return currentSection; }
 	uint32_t numFrames();
+	uint32_t numSections() const { return header.numSections; }
+	std::string getSectionName(uint32_t) const;
+
+	/* Interpolated transform for a section at a fractional frame time, which
+	 * wraps around so the animation loops.  Written as a GL matrix like
+	 * loadGLMatrix
+	 */
+	void sample(uint32_t, float, float*) const;
+	/* The same for every section, 16 floats each */
+	void sampleAll(float, float*) const;
 
 	void print();
 };
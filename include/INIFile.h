@@ -22,35 +22,85 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include <stdio.h>
 #include "Exception.h"
 
+/* Not safe to share between threads, even through the const members:
+ * selecting a section, lazily parsing one and the typed getters all update
+ * cached state
+ */
 class INIFile {
+public:
+	/* A key's value as read, along with whatever the typed getters have made
+	 * of it.  Each type is only ever parsed once per value
+	 */
+	class Value {
+		friend class INIFile;
+		static unsigned int const IntDone = 1, IntOk = 1 << 1;
+		static unsigned int const FloatDone = 1 << 2, FloatOk = 1 << 3;
+		static unsigned int const BoolDone = 1 << 4, BoolOk = 1 << 5;
+		static unsigned int const IntListDone = 1 << 6, IntListOk = 1 << 7;
+		static unsigned int const StringListDone = 1 << 8;
+		mutable unsigned int flags;
+		mutable int intVal;
+		mutable float floatVal;
+		mutable bool boolVal;
+		mutable std::vector<int> intList;
+		mutable std::vector<std::string> stringList;
+	public:
+		std::string str;
+		Value() : flags(0) { }
+		Value(std::string const& s) : flags(0), str(s) { }
+	};
 protected:
-	typedef std::map<std::string, std::string> Section;
+	typedef std::map<std::string, Value> Section;
 	typedef std::map<std::string, Section> SectionMap;
-	SectionMap sections;
+	/* Byte ranges in text of the bodies of sections which have not been
+	 * parsed yet (lazy mode only).  Parsing one moves it into sections, so
+	 * both are mutable to allow that from const lookups
+	 */
+	typedef std::vector<std::pair<size_t, size_t> > Ranges;
+	typedef std::map<std::string, Ranges> PendingMap;
+	mutable SectionMap sections;
+	mutable PendingMap pending;
+	std::string text;
 	SectionMap::iterator currentSection;
+
+	Value const* findValue(std::string const& key) const;
 	bool parseIniLine(char const* line);
+	void parseText(char const* p, size_t len);
+	void parseRead(bool lazy);
+	void scanSections();
+	void loadSection(PendingMap::iterator it) const;
+	void loadAll() const;
 	bool trim(std::string& str, std::string const& trimchars);
 public:
 	typedef SectionMap::const_iterator section_iterator;
 	typedef Section::const_iterator key_iterator;
 
 	INIFile();
-	INIFile(std::string const& fn);
+	INIFile(std::string const& fn, bool lazy = false);
 	bool sectionExists(std::string const& section) const;
+	bool getNumberedValues(std::string const& section, std::vector<std::pair<char const*, size_t> >& pieces) const;
 	void setCurrentSection(std::string const& section);
 	std::string getCurrentSectionName() const;
 	bool keyExists(std::string const& key) const;
 	std::string getKey(std::string const& key) const;
+	std::string const* findKey(std::string const& key) const;
+	bool getInt(std::string const& key, int& val) const;
+	bool getFloat(std::string const& key, float& val) const;
+	bool getBool(std::string const& key, bool& val) const;
+	bool getIntList(std::string const& key, std::vector<int>& val) const;
+	bool getStringList(std::string const& key, std::vector<std::string>& val) const;
 	void setKey(std::string const& key, std::string const& val);
 	void eraseSection();
 	void eraseKey(std::string const& key);
 	void write(std::string const& fn) const;
 	void write(FILE* fp) const;
-	void read(std::string const& fn);
-	void read(FILE* fp);
+	void read(std::string const& fn, bool lazy = false);
+	void read(FILE* fp, bool lazy = false);
+	void read(char const* data, size_t len, bool lazy = false);
 
 	section_iterator sectionsBegin();
 	section_iterator sectionsEnd();
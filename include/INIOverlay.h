@@ -0,0 +1,91 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef INIOVERLAY_H__
+#define INIOVERLAY_H__
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "INIFile.h"
+
+/* A stack of INIFiles (e.g. rules, then the map's overrides, then a mod's)
+ * read as one: a key comes from the highest layer that has it.  Lookups go
+ * through a single hash index over every section/key in any layer, so they
+ * cost the same however many layers there are.
+ *
+ * The overlay points at the layers' values rather than copying them, so
+ * after changing a layer call layerChanged() with its index before looking
+ * anything else up.
+ */
+class INIOverlay {
+protected:
+	struct Entry {
+		std::string section;
+		std::string key;
+		uint32_t hash;
+		/* Value from each layer, NULL where the layer doesn't have the key */
+		std::vector<std::string const*> values;
+		std::string const* value;
+	};
+	struct Layer {
+		INIFile* ini;
+		std::vector<uint32_t> entries;
+		std::vector<std::string> sections;
+	};
+	static uint32_t const emptySlot;
+
+	std::vector<Layer> layers;
+	std::vector<Entry> entries;
+	/* Open addressing (linear probing) table of indices into entries, entries
+	 * are never removed, a key that has gone from every layer just has a NULL
+	 * value
+	 */
+	std::vector<uint32_t> table;
+	std::map<std::string, unsigned int> sectionLayers;
+	std::string currentSection;
+	bool haveSection;
+
+	static uint32_t hash(std::string const&, std::string const&);
+	uint32_t lookup(std::string const&, std::string const&, uint32_t) const;
+	uint32_t insert(std::string const&, std::string const&);
+	void grow();
+	void resolve(Entry&);
+	void unindexLayer(size_t);
+	void indexLayer(size_t);
+public:
+	INIOverlay();
+
+	size_t addLayer(INIFile& ini);
+	size_t numLayers() const;
+	void layerChanged(size_t layer);
+
+	bool sectionExists(std::string const& section) const;
+	void setCurrentSection(std::string const& section);
+	std::string getCurrentSectionName() const;
+	bool keyExists(std::string const& key) const;
+	std::string getKey(std::string const& key) const;
+	std::string const* findKey(std::string const& key) const;
+	std::string const* findKey(std::string const& section, std::string const& key) const;
+	int getKeyLayer(std::string const& key) const;
+};
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef ISOMAPPACK_H__
+#define ISOMAPPACK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/* Unpacked IsoMapPack5 data stored a column per field rather than a struct
+ * per cell, with a dense grid from cell position to cell index.  Filters
+ * over a single field (e.g. a tile range) only touch that field's array.
+ */
+class IsoMapPack {
+public:
+	static uint32_t const noCell;
+	static size_t const cellSize;
+protected:
+	std::vector<int16_t> x;
+	std::vector<int16_t> y;
+	std::vector<int16_t> tile;
+	std::vector<uint8_t> subTile;
+	std::vector<int8_t> z;
+
+	int32_t minX, minY;
+	uint32_t width, height;
+	std::vector<uint32_t> grid;
+
+	void buildGrid();
+public:
+	IsoMapPack(uint8_t const* data, size_t len);
+
+	uint32_t numCells() const;
+	int16_t const* getX() const;
+	int16_t const* getY() const;
+	int16_t const* getTile() const;
+	uint8_t const* getSubTile() const;
+	int8_t const* getZ() const;
+
+	void getBounds(int32_t& x, int32_t& y, uint32_t& w, uint32_t& h) const;
+	uint32_t findCell(int32_t x, int32_t y) const;
+	uint32_t const* getRow(int32_t y) const;
+
+	size_t findTiles(int16_t first, int16_t last, std::vector<uint32_t>& cells) const;
+	size_t countTiles(int16_t first, int16_t last) const;
+	void print() const;
+};
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef LZOCOMPRESS_H__
+#define LZOCOMPRESS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+class LZOCompress {
+protected:
+	LZOCompress() { }
+	~LZOCompress() { }
+public:
+	static size_t maxCompressedSize(size_t inlen);
+	static size_t compress(uint8_t const* in, uint8_t* out, size_t inlen, size_t outlen);
+};
+
+#endif
@@ -25,12 +25,13 @@
 
 class LZODecompress {
 protected:
-	static char const * errorText[];
-	static void initLZO();
 	LZODecompress() { }
 	~LZODecompress() { }
 public:
+	static char const * errorText[];
+	static void initLZO();
 	static size_t decompress(uint8_t const* in, uint8_t* out, size_t inlen, size_t outlen);
+	static size_t decompressFast(uint8_t const* in, uint8_t* out, size_t inlen, size_t outlen);
 };
 
 #endif
@@ -0,0 +1,70 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MAPCHUNKCACHE_H__
+#define MAPCHUNKCACHE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <list>
+#include <map>
+#include <vector>
+#include "MapRenderer.h"
+
+/* Renders a map on demand in fixed size square chunks, keeping the most
+ * recently used chunks until a memory budget is reached.  Only the chunks
+ * intersecting the requested viewport are ever drawn, so the cost of
+ * panning is proportional to the newly exposed area rather than the map.
+ */
+class MapChunkCache {
+public:
+	struct Chunk {
+		uint32_t key;
+		uint8_t* pixels;
+	};
+protected:
+	typedef std::list<Chunk> ChunkList;
+	typedef std::map<uint32_t, ChunkList::iterator> ChunkMap;
+
+	MapRenderer const& renderer;
+	uint32_t chunkSize;
+	uint32_t chunksX, chunksY;
+	size_t budget;
+	ChunkList chunks;		/* Most recently used first */
+	ChunkMap index;
+	MapRenderer::RowBuckets rowCells;	/* Cells touching each row of chunks */
+	uint32_t hits, misses;
+
+	void renderChunk(uint32_t, uint32_t, uint8_t*) const;
+	void evict(size_t);
+public:
+	MapChunkCache(MapRenderer const&, uint32_t = 256, size_t = 64 << 20);
+	~MapChunkCache();
+
+	uint32_t getChunkSize() const;
+	uint8_t const* getChunk(uint32_t, uint32_t);
+	void renderViewport(uint8_t*, size_t, int32_t, int32_t, uint32_t, uint32_t);
+	void setBudget(size_t);
+	void clear();
+
+	void print();
+};
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MAPINDEX_H__
+#define MAPINDEX_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class INIFile;
+
+/* A catalogue of map metadata, saved as one binary file.  Each entry keeps
+ * the file's size, modification time and a hash of its contents so a
+ * rescan only has to read maps which have changed.
+ *
+ * The file is a header ("RA2I", version, count) followed by the entries;
+ * integers are little endian and strings and images are length prefixed.
+ * Preview and radar images are 24 bit RGB and may be empty.
+ */
+class MapIndex {
+public:
+	static uint32_t const version;
+
+	struct Image {
+		uint16_t width, height;
+		std::vector<uint8_t> rgb;
+		Image() : width(0), height(0) { }
+		void fromRGBA(uint8_t const*, uint16_t, uint16_t);
+	};
+	struct Entry {
+		std::string path;
+		uint64_t fileSize;
+		int64_t modified;	/* Nanoseconds since the epoch */
+		uint64_t hash;
+
+		std::string name;
+		std::string theater;
+		int32_t size[4];
+		int32_t localSize[4];
+		uint8_t players;
+		Image preview;
+		Image radar;
+
+		Entry();
+		void readMetadata(INIFile&);
+	};
+protected:
+	typedef std::map<std::string, Entry> EntryMap;
+	EntryMap entries;
+public:
+	MapIndex() { }
+	~MapIndex() { }
+
+	static uint64_t hash(uint8_t const*, size_t);
+
+	void read(std::string const&);
+	void write(std::string const&) const;
+
+	size_t numEntries() const;
+	Entry const* find(std::string const&) const;
+	void set(Entry const&);
+	void retain(std::vector<std::string> const&);
+
+	typedef EntryMap::const_iterator iterator;
+	iterator begin() const { return entries.begin(); }
+	iterator end() const { return entries.end(); }
+};
+
+#endif
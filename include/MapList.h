@@ -0,0 +1,57 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MAPLIST_H__
+#define MAPLIST_H__
+
+#include "WorkQueue.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/* The maps given to a batch tool, with any directories expanded to the map
+ * files in them, processed across all the processors.  Subclasses implement
+ * process(); a map that throws is reported on stderr and marked Failed
+ * rather than stopping the whole run, as one broken upload is common.
+ */
+class MapList : public WorkQueue::Task {
+protected:
+	std::vector<std::string> maps;
+	std::vector<uint8_t> status;
+
+	/* Returns the map's status, anything but Failed */
+	virtual uint8_t process(size_t n, std::string const& file) = 0;
+public:
+	static uint8_t const Failed;
+
+	static bool isMapFile(std::string const& name);
+	void add(std::string const& path);
+	void add(char** paths, int n);
+
+	size_t size() const { return maps.size(); }
+	std::string const& getMap(size_t n) const { return maps[n]; }
+	uint8_t getStatus(size_t n) const { return status[n]; }
+	size_t count(uint8_t s) const;
+
+	void run(size_t n);
+	void runAll();
+};
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MAPPREVIEW_H__
+#define MAPPREVIEW_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+class INIFile;
+
+/* A map's [Preview] image: PreviewPack is LZO packed 24 bit RGB with the
+ * dimensions given by the [Preview] Size key (x, y, width, height)
+ */
+class MapPreview {
+protected:
+	typedef void (*Converter)(uint8_t const*, uint8_t*, size_t);
+	static Converter converter;
+
+	static void initialiseConverter();
+	static void initialise();
+	MapPreview() { }
+	~MapPreview() { }
+public:
+	static bool getSize(INIFile&, uint32_t&, uint32_t&);
+	static void rgbToRGBA(uint8_t const*, uint8_t*, size_t);
+	static void decode(INIFile&, uint8_t*, uint32_t, uint32_t, unsigned int threads = 1);
+};
+
+#endif
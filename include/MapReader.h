@@ -50,16 +50,22 @@ public:
 	};
 	uint32_t numEntries;
 	Entry* entry;
-protected:
 	struct PackSectionInfo {
 		uint16_t packedLen;
 		uint16_t unpackedLen;
 		uint8_t const* packedData;
 	};
 public:	
+	static unsigned int const decode4TableSize;
 	static size_t decode4(uint16_t*, size_t, uint8_t*, size_t, Palette&);
+	static void buildDecode4Table(Palette const&, uint64_t*);
+	static size_t decode4(uint16_t const*, size_t, uint8_t*, size_t, uint64_t const*);
 	static size_t decode80(uint8_t const*, uint8_t*, size_t, size_t);
-	static uint8_t* unpack(uint8_t const*, size_t, size_t&, int = LZOPack);
+	static size_t decode80Reference(uint8_t const*, uint8_t*, size_t, size_t);
+	static uint8_t* unpack(uint8_t const*, size_t, size_t&, int = LZOPack, unsigned int threads = 0);
+	static size_t maxEncoded80Size(size_t);
+	static size_t encode80(uint8_t const*, uint8_t*, size_t, size_t);
+	static uint8_t* pack(uint8_t const*, size_t, size_t&, int = LZOPack, size_t sectionSize = 8192, unsigned int threads = 0);
 
 	MapReader() : entry(NULL) { }
 	~MapReader() { delete[] entry; }
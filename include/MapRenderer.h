@@ -0,0 +1,87 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MAPRENDERER_H__
+#define MAPRENDERER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "MapReader.h"
+#include "Theater.h"
+#include "Palette.h"
+#include "TileMips.h"
+
+/* Draws the terrain described by IsoMapPack5 using the templates of a
+ * theater.  Cells are placed isometrically (x - y across, x + y down) and
+ * raised by half a tile per height level, then drawn back to front.  The
+ * image is split into horizontal bands which are rendered independently, so
+ * painter order only has to hold within each band.
+ *
+ * renderDepth instead resolves overlaps with a depth buffer built from the
+ * tiles' Z data, so cells can be drawn in any order and the image is split
+ * into square regions.  Depth increases towards the viewer: a cell's base
+ * depth is its unraised screen row plus half a tile per height level, and
+ * each pixel adds its Z value on top of that.
+ */
+class MapRenderer {
+public:
+	static int32_t const levelHeight;
+	struct Cell {
+		int32_t x, y;			/* Image position of the tile */
+		int32_t left, right;		/* Columns covered by the tile and its extra */
+		int32_t top, bottom;		/* Rows covered by the tile and its extra */
+		TMPFile const* tmp;
+		uint32_t tile;
+		uint32_t subTile;
+		int32_t depth;			/* Base depth, see renderDepth */
+	};
+	typedef std::vector<std::vector<uint32_t> > RowBuckets;
+protected:
+	typedef std::vector<Cell> CellVec;
+	Theater const& theater;
+	CellVec cells;
+	uint32_t width;
+	uint32_t height;
+	int32_t thumbX, thumbY;		/* Where the cell lattice falls under thumbnail pixels */
+public:
+	MapRenderer(MapReader const&, Theater const&);
+	~MapRenderer() { }
+
+	void getSize(uint32_t&, uint32_t&) const;
+	size_t numCells() const;
+	Cell const& getCell(size_t) const;
+	void drawCell(Cell const&, uint8_t*, size_t, int32_t, int32_t, int32_t, int32_t) const;
+	void renderBand(uint8_t*, size_t, int32_t, int32_t) const;
+	void render(uint8_t*, size_t, unsigned int = 0) const;
+	void renderRGBA(uint8_t*, Palette const&, unsigned int = 0, bool = false) const;
+	void bucketRows(uint32_t, RowBuckets&) const;
+
+	static void drawDepth(uint8_t const*, uint8_t const*, int32_t, int32_t, int32_t, int32_t, int32_t,
+		uint8_t*, uint16_t*, size_t, int32_t, int32_t, int32_t, int32_t);
+	void drawCellDepth(Cell const&, uint8_t*, uint16_t*, size_t, int32_t, int32_t, int32_t, int32_t) const;
+	void renderDepth(uint8_t*, uint16_t*, size_t, unsigned int = 0) const;
+
+	void getThumbnailSize(unsigned int, uint32_t&, uint32_t&) const;
+	void renderThumbnailBand(uint8_t*, TileMips const&, unsigned int, int32_t, int32_t) const;
+	void renderThumbnail(uint8_t*, TileMips const&, unsigned int, unsigned int = 0) const;
+};
+
+#endif
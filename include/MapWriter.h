@@ -0,0 +1,64 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MAPWRITER_H__
+#define MAPWRITER_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <map>
+#include <string>
+#include "INIFile.h"
+#include "Utils.h"
+
+/* Writes a map: the INI sections as they are, plus pack sections built
+ * from raw data.  On write every pack is compressed (sections in parallel),
+ * Base64 encoded and written out as numbered 70 character lines, all
+ * through one output buffer.  Packs replace any section of the same name
+ * in the INI file.
+ */
+class MapWriter {
+public:
+	static size_t const lineLength;
+protected:
+	struct Pack {
+		uint8_t const* data;
+		size_t len;
+		int format;
+		std::string encoded;
+	};
+	typedef std::map<std::string, Pack> PackMap;
+
+	INIFile& ini;
+	PackMap packs;
+	unsigned int threads;
+
+	void encodePacks();
+	static void writeSection(Utils::BufferedWrite&, std::string const&, INIFile::key_iterator, INIFile::key_iterator);
+	static void writePack(Utils::BufferedWrite&, std::string const&, std::string const&);
+public:
+	MapWriter(INIFile& ini, unsigned int threads = 0);
+
+	void setPack(std::string const& section, uint8_t const* data, size_t len, int format);
+	void write(std::string const& fn);
+	void write(FILE* fp);
+};
+
+#endif
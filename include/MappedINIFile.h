@@ -0,0 +1,104 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MAPPEDINIFILE_H__
+#define MAPPEDINIFILE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Exception.h"
+
+/* Read only INI file which maps the file into memory and indexes it in place.
+ * Section names, keys and values are references into the mapping, so
+ * parsing allocates nothing per key.  The parsing rules are the same as
+ * INIFile (first definition of a key wins, sections of the same name are
+ * merged) except that there is no limit on line length.
+ */
+class MappedINIFile {
+public:
+	struct StringRef {
+		char const* str;
+		size_t len;
+
+		StringRef() : str(NULL), len(0) { }
+		StringRef(char const* s, size_t l) : str(s), len(l) { }
+		std::string toString() const {
+			return std::string(str, len);
+		}
+		bool equals(char const* s, size_t l) const;
+	};
+	struct Key {
+		StringRef key;
+		StringRef value;
+		uint32_t section;
+	};
+	typedef Key const* key_iterator;
+protected:
+	struct Section {
+		StringRef name;
+		uint32_t firstKey;
+		uint32_t numKeys;
+	};
+	static uint32_t const emptySlot;
+
+	char const* data;
+	size_t size;
+	std::vector<Section> sections;
+	std::vector<Key> keys;
+	/* Open addressing tables (linear probing) holding indices into
+	 * sections/keys, sized to a power of two
+	 */
+	std::vector<uint32_t> sectionTable;
+	std::vector<uint32_t> keyTable;
+	uint32_t currentSection;
+
+	static uint32_t hash(char const*, size_t, uint32_t = 2166136261u);
+	static uint32_t keyHash(uint32_t, char const*, size_t);
+	static void trim(char const*&, char const*&, char const*);
+	uint32_t lookupSection(char const*, size_t) const;
+	void placeSection(uint32_t);
+	uint32_t insertSection(char const*, size_t);
+	void parseLine(char const*, char const*);
+	void parse();
+	void buildKeyTable();
+
+	MappedINIFile(MappedINIFile const&);
+	MappedINIFile& operator=(MappedINIFile const&);
+public:
+	MappedINIFile(std::string const& fn);
+	~MappedINIFile();
+
+	size_t numSections() const;
+	std::string getSectionName(size_t) const;
+	bool sectionExists(std::string const& section) const;
+	void setCurrentSection(std::string const& section);
+	std::string getCurrentSectionName() const;
+	bool keyExists(std::string const& key) const;
+	std::string getKey(std::string const& key) const;
+	bool findKey(std::string const& key, StringRef& value) const;
+	bool findKey(char const* key, size_t len, StringRef& value) const;
+
+	key_iterator keysBegin() const;
+	key_iterator keysEnd() const;
+};
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef OVERLAYGRID_H__
+#define OVERLAYGRID_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class INIFile;
+
+/* The unpacked OverlayPack and OverlayDataPack of a map.  Both are one byte
+ * per cell for a 512 x 512 grid indexed by y * 512 + x, using the same cell
+ * coordinates as IsoMapPack5.  An overlay of 0xFF means the cell has none;
+ * for ore and gems the data byte is the growth stage (0-11) and for walls
+ * it says which neighbours the wall connects to.
+ */
+class OverlayGrid {
+public:
+	static uint32_t const size;
+	static uint8_t const noOverlay;
+
+	static uint8_t const None;
+	static uint8_t const Ore;
+	static uint8_t const Gem;
+	static uint8_t const Wall;
+	/* Entries in a table of classes, one per overlay number */
+	static size_t const classTableSize;
+
+	struct ResourceCount {
+		uint32_t oreCells;
+		uint32_t oreAmount;
+		uint32_t gemCells;
+		uint32_t gemAmount;
+		ResourceCount() : oreCells(0), oreAmount(0), gemCells(0), gemAmount(0) { }
+	};
+	struct WallSegment {
+		uint8_t overlay;
+		uint32_t cells;
+		uint16_t minX, minY, maxX, maxY;
+		uint16_t firstX, firstY;
+	};
+protected:
+	std::vector<uint8_t> overlay;
+	std::vector<uint8_t> data;
+	uint8_t classes[256];
+public:
+	OverlayGrid(uint8_t const* overlayPack, size_t overlayLen, uint8_t const* dataPack, size_t dataLen);
+
+	static void defaultClasses(uint8_t* classes);
+	static bool buildClasses(INIFile& rules, uint8_t* classes);
+	bool loadClasses(INIFile& rules);
+	void setClasses(uint8_t const* classes);
+	uint8_t getClass(uint8_t overlay) const;
+
+	uint8_t getOverlay(uint32_t x, uint32_t y) const;
+	uint8_t getData(uint32_t x, uint32_t y) const;
+	uint8_t const* getOverlayRow(uint32_t y) const;
+	uint8_t const* getDataRow(uint32_t y) const;
+
+	ResourceCount countResources(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const;
+	uint32_t countResourcesByRegion(uint32_t regionSize, std::vector<ResourceCount>& regions) const;
+	void listWalls(std::vector<WallSegment>& segments) const;
+};
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef PACKCACHE_H__
+#define PACKCACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class INIFile;
+
+/* Keeps unpacked pack sections (Base64 decoded then MapReader::unpack-ed)
+ * keyed by a hash of the section's values, so reloading a map after a save
+ * only unpacks the packs which actually changed.  Hashing the text is much
+ * cheaper than decoding it, and for a lazily read map an unchanged pack
+ * section is never even parsed.
+ *
+ * Least recently used packs are dropped once the total size goes over the
+ * limit.  Buffers returned by get() stay valid until a later get() on the
+ * same cache (which may evict them) or the cache is destroyed; a cache
+ * must not be shared between threads.
+ */
+class PackCache {
+protected:
+	struct Key {
+		std::string section;
+		int format;
+		uint64_t hash;
+		size_t textLen;
+		bool operator<(Key const&) const;
+	};
+	struct Entry {
+		std::vector<uint8_t> data;
+		unsigned long lastUse;
+	};
+	typedef std::map<Key, Entry> EntryMap;
+	EntryMap entries;
+	size_t maxBytes;
+	size_t totalBytes;
+	unsigned long uses;
+	unsigned long hits;
+	unsigned long misses;
+	std::vector<std::pair<char const*, size_t> > pieces;
+
+	void evict(EntryMap::iterator keep);
+public:
+	PackCache(size_t maxBytes = 64 << 20);
+	~PackCache() { }
+
+	uint8_t const* get(INIFile& map, std::string const& section, int format, size_t& len, unsigned int threads = 0);
+	void clear();
+
+	size_t size() const;
+	unsigned long getHits() const;
+	unsigned long getMisses() const;
+};
+
+#endif
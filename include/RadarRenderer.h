@@ -0,0 +1,49 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef RADARRENDERER_H__
+#define RADARRENDERER_H__
+
+#include <stdint.h>
+#include "MapReader.h"
+#include "Theater.h"
+
+/* Builds the radar (minimap) image of a map the same way the game does,
+ * from the radar colours stored in each tile header.  No tile pixels are
+ * needed, so the theater can be loaded with headersOnly set.
+ *
+ * Each cell covers two horizontally adjacent pixels, the left and right
+ * radar colours, at column (x - y) and row (x + y).  Neighbouring cells in
+ * a row are two columns apart, so the result is a solid 2:1 diamond.
+ */
+class RadarRenderer {
+protected:
+	MapReader const& map;
+	int32_t minU, minV;
+	uint32_t width, height;
+public:
+	RadarRenderer(MapReader const&);
+	~RadarRenderer() { }
+
+	void getSize(uint32_t&, uint32_t&) const;
+	void render(uint8_t*, Theater const&) const;
+};
+
+#endif
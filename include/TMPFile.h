@@ -65,9 +65,12 @@ public:
 		
 		uint8_t pad[3];
 
-		bool hasExtra() {
+		bool hasExtra() const {
 			return flags & hasExtraData;
 		}
+		bool hasExtraZ() const {
+			return (flags & hasExtraData) && (flags & hasZData);
+		}
 		int32_t getX() {
 			return x;
 		}
@@ -86,18 +89,24 @@ public:
 		uint8_t* tile;
 		uint8_t* height;
 		uint8_t* extra;
+		uint8_t* extraHeight;
 
-		TileData() : tile(NULL), height(NULL), extra(NULL) { }
+		TileData() : tile(NULL), height(NULL), extra(NULL), extraHeight(NULL) { }
 		~TileData() {
 			delete[] tile;
 			delete[] height;
 			delete[] extra;
+			delete[] extraHeight;
 		}
-		void alloc(size_t extraSz = 0) {
-			tile = new uint8_t[ra2TileWidth * ra2TileHeight];
-			height = new uint8_t[ra2TileWidth * ra2TileHeight];
+		void alloc(size_t extraSz = 0, bool extraZ = false) {
+			/* Only the diamond is stored in the file, the corners must be transparent */
+			tile = new uint8_t[ra2TileWidth * ra2TileHeight]();
+			height = new uint8_t[ra2TileWidth * ra2TileHeight]();
 			if(extraSz) {
 				extra = new uint8_t[extraSz];
+				if(extraZ) {
+					extraHeight = new uint8_t[extraSz];
+				}
 			}
 		}
 	};
@@ -106,14 +115,19 @@ protected:
 	TileHeader* tileHeader;
 	TileData* tileData;
 	uint32_t currentTile;
+	bool headersOnly;
 
 	void readTile(uint32_t, Utils::FixedRead&);
 	void readIsoToSqr(uint8_t*, Utils::FixedRead&);
 public:
-	TMPFile(std::string const&);
+	TMPFile(std::string const&, bool = false);
 	~TMPFile();
 
-	uint32_t numTiles();
+	uint32_t numTiles() const;
+	bool hasTile(uint32_t) const;
+	bool hasTileData() const;
+	TileHeader const& getTileHeader(uint32_t) const;
+	TileData const& getTileData(uint32_t) const;
 
 	void setCurrentTile(unsigned int, unsigned int);
 	void setCurrentTile(uint32_t);
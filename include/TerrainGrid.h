@@ -0,0 +1,88 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef TERRAINGRID_H__
+#define TERRAINGRID_H__
+
+#include <stdint.h>
+#include <vector>
+#include "MapReader.h"
+#include "Theater.h"
+
+/* Per-cell terrain and passability for a map, built from the terrain and
+ * ramp types in the tile header of each cell's template.  The grid covers
+ * the bounding box of the map's cells in IsoMapPack5 coordinates.
+ *
+ * Each layer is one bit per cell, rows padded to whole 64 bit words, so
+ * they can be combined and counted a word at a time.  The land type is
+ * kept as well, packed two cells per byte.
+ */
+class TerrainGrid {
+public:
+	/* The game's LandType values */
+	static uint8_t const Clear;
+	static uint8_t const Road;
+	static uint8_t const Water;
+	static uint8_t const Rock;
+	static uint8_t const Wall;
+	static uint8_t const Tiberium;
+	static uint8_t const Beach;
+	static uint8_t const Rough;
+	static uint8_t const Ice;
+	static uint8_t const Railroad;
+	static uint8_t const Tunnel;
+	static uint8_t const Weeds;
+	static uint8_t const NoTile;
+
+	/* Layers */
+	static unsigned int const Present;
+	static unsigned int const Land;
+	static unsigned int const Naval;
+	static unsigned int const Ramp;
+	static unsigned int const numLayers;
+protected:
+	int32_t minX, minY;
+	uint32_t width, height, rowWords;
+	std::vector<uint64_t> layers;
+	std::vector<uint8_t> landTypes;
+
+	uint64_t* layerRow(unsigned int layer, uint32_t y) {
+		return &layers[(static_cast<size_t>(layer) * height + y) * rowWords];
+	}
+	void set(unsigned int, uint32_t, uint32_t);
+	void setLandType(uint32_t, uint32_t, uint8_t);
+public:
+	TerrainGrid(MapReader const&, Theater const&);
+	~TerrainGrid() { }
+
+	static uint8_t landType(uint8_t terrainType);
+
+	void getBounds(int32_t&, int32_t&, uint32_t&, uint32_t&) const;
+	uint32_t getRowWords() const;
+	uint64_t const* getLayerRow(unsigned int layer, uint32_t y) const {
+		return &layers[(static_cast<size_t>(layer) * height + y) * rowWords];
+	}
+	bool test(unsigned int layer, int32_t x, int32_t y) const;
+	uint8_t getLandType(int32_t x, int32_t y) const;
+	uint32_t countCells(unsigned int layer) const;
+	uint32_t labelRegions(unsigned int layer, std::vector<uint32_t>& labels, std::vector<uint32_t>& sizes) const;
+};
+
+#endif
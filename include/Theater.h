@@ -0,0 +1,47 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef THEATER_H__
+#define THEATER_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "TMPFile.h"
+
+/* The set of TMP templates making up a theater, indexed by the tile number
+ * used in IsoMapPack5.  The tile numbering comes from the theater INI file
+ * (temperatmd.ini etc.), where each [TileSetNNNN] section contributes
+ * TilesInSet templates named <FileName><01..NN>.<ext>
+ */
+class Theater {
+protected:
+	typedef std::vector<TMPFile*> TileVec;
+	TileVec tiles;
+
+	TMPFile* loadTemplate(std::string const&, std::string const&, bool);
+public:
+	Theater(std::string const& ini, std::string const& dir, std::string const& ext, bool headersOnly = false);
+	~Theater();
+
+	uint32_t numTiles() const;
+	TMPFile const* getTile(uint32_t) const;
+};
+
+#endif
@@ -0,0 +1,46 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef THEATERCACHE_H__
+#define THEATERCACHE_H__
+
+#include "Theater.h"
+#include <pthread.h>
+#include <map>
+#include <string>
+
+/* Theaters for batch jobs over many maps, found by the name in the map's
+ * [Map] Theater key.  Each is loaded (headers only) the first time a map
+ * uses it; get() is safe to call from several threads.
+ */
+class TheaterCache {
+protected:
+	typedef std::map<std::string, Theater*> TheaterMap;
+	std::string dataDir;
+	TheaterMap theaters;
+	pthread_mutex_t lock;
+public:
+	TheaterCache(std::string const& dir);
+	~TheaterCache();
+
+	Theater const& get(std::string const& name);
+};
+
+#endif
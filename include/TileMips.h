@@ -0,0 +1,70 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef TILEMIPS_H__
+#define TILEMIPS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "Theater.h"
+#include "Palette.h"
+
+/* Reduced size RGBA copies of every template in a theater at 1/2, 1/4 and
+ * 1/8 scale, built once so that thumbnails can be drawn directly at their
+ * final size.  Each level keeps its images packed into a single atlas
+ * buffer.  Alpha is the fraction of opaque pixels the output pixel covers.
+ *
+ * A template is shrunk once for each sub-pixel position a cell can have at
+ * that scale (2, 8 and 32 images per level), so the three levels together
+ * take about one and a half times the memory of the full size templates.
+ */
+class TileMips {
+public:
+	static unsigned int const numLevels;
+	struct Image {
+		size_t offset;		/* Into the level's atlas */
+		uint32_t w, h;
+		int32_t x, y;		/* Full size offset from the cell position */
+	};
+	struct Entry {
+		Image tile;
+		Image extra;		/* w == 0 if there is no extra data */
+	};
+protected:
+	struct Level {
+		std::vector<uint8_t> atlas;
+		std::vector<Entry> entries;
+	};
+	std::vector<uint32_t> firstEntry;	/* Indexed by theater tile number, counts sub-tiles */
+	std::vector<uint32_t> numEntries;
+	std::vector<Level> levels;
+
+	void shrink(Level&, Image&, unsigned int, int32_t, int32_t, uint8_t const*, uint32_t, uint32_t, uint8_t const (*)[3]);
+public:
+	TileMips(Theater const&, Palette const&);
+	~TileMips() { }
+
+	Entry const* getEntry(uint32_t, uint32_t, unsigned int, int32_t, int32_t) const;
+	uint8_t const* getPixels(Image const&, unsigned int) const;
+	size_t getMemoryUsage() const;
+};
+
+#endif
@@ -21,6 +21,7 @@
 #define UTILS_H__
 
 #include <stdio.h>
+#include <stdint.h>
 #include <errno.h>
 #include <string.h>
 #include <string>
@@ -73,6 +74,55 @@ namespace Utils {
 			}
 		}
 	};
+	/* Collects small writes into large fwrites.  Call flush() at the end to
+	 * see any error, the destructor flushes too but has to ignore them
+	 */
+	class BufferedWrite {
+	protected:
+		FILE* f;
+		std::vector<char> buf;
+		size_t used;
+	public:
+		BufferedWrite(FILE* fp, size_t size = 1 << 16) : f(fp), buf(size), used(0) { }
+		~BufferedWrite() {
+			if(used != 0) {
+				fwrite(&buf[0], 1, used, f);
+			}
+		}
+
+		void flush() {
+			if(used != 0 && fwrite(&buf[0], 1, used, f) != used) {
+				used = 0;
+				throw EXCEPTION("Could not write to stream (%s)", strerror(errno));
+			}
+			used = 0;
+		}
+
+		void write(void const* data, size_t len) {
+			if(used + len > buf.size()) {
+				flush();
+				if(len >= buf.size()) {
+					if(fwrite(data, 1, len, f) != len) {
+						throw EXCEPTION("Could not write %u bytes to stream (%s)", len, strerror(errno));
+					}
+					return;
+				}
+			}
+			memcpy(&buf[used], data, len);
+			used += len;
+		}
+
+		void write(std::string const& str) {
+			write(str.data(), str.length());
+		}
+
+		void write(char c) {
+			if(used == buf.size()) {
+				flush();
+			}
+			buf[used++] = c;
+		}
+	};
 	template<typename T>
 	struct ScopedArray {
 		T* ptr;
@@ -97,6 +147,15 @@ namespace Utils {
 		split(in, tmp, delim);
 		return tmp;
 	}
+	/* 64 bit FNV-1a, pass the previous result as h to hash data in pieces */
+	inline uint64_t fnv1a64(void const* data, size_t len, uint64_t h = 0xCBF29CE484222325ULL) {
+		unsigned char const* p = static_cast<unsigned char const*>(data);
+		for(size_t i = 0; i != len; i++) {
+			h ^= p[i];
+			h *= 0x100000001B3ULL;
+		}
+		return h;
+	}
 	template<typename T>
 	std::string toString(T v) {
 		std::ostringstream tmp;
@@ -22,7 +22,9 @@
 
 #include "VXLFile.h"
 #include "HVAFile.h"
+#include "BakedModel.h"
 #include <SDL/SDL_opengl.h>
+#include <vector>
 
 class VoxelRenderer {
 public:
@@ -31,19 +33,29 @@ public:
 	static float lightLight[4];
 	static float lightAmb[4];
 protected:
-	void renderSection(bool, bool);
+	void renderSection(float const*, bool, bool);
 	void renderVoxel(float, float, float, float);
+	void bindSections();
 
 	VXLFile& vxl;
 	HVAFile* hva;
+	/* HVA section index of each limb, looked up once when the HVA is set */
+	std::vector<uint32_t> limbSections;
+	/* Every section's matrix for the current frame when it falls between
+	 * keyframes
+	 */
+	std::vector<float> sampled;
 public:
-	uint32_t frame;
+	/* Fractional HVA frame, rendered interpolated between keyframes */
+	float frame;
 	float pitch;
 
-	VoxelRenderer(VXLFile& v, HVAFile* h = NULL) : vxl(v), hva(h), frame(0), pitch(0) { }
+	VoxelRenderer(VXLFile& v, HVAFile* h = NULL) : vxl(v), hva(h), frame(0), pitch(0) { bindSections(); }
 	~VoxelRenderer() { }
 
 	void render(bool = true, bool = true);
+	/* Plays back a model baked from this renderer's VXL, at frame */
+	void render(BakedModel const&, bool = true, bool = true);
 	void setHVA(HVAFile*);
 	static void setupLighting(int = GL_LIGHT0);
 };
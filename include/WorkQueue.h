@@ -0,0 +1,57 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef WORKQUEUE_H__
+#define WORKQUEUE_H__
+
+#include <stddef.h>
+#include <pthread.h>
+#include "Exception.h"
+
+/* Runs a fixed number of independent work items across a set of threads.
+ * Items are handed out in index order; if any item throws, the exception
+ * from the lowest failing index is rethrown once all threads have finished,
+ * so the error reported does not depend on thread scheduling.
+ */
+class WorkQueue {
+public:
+	struct Task {
+		virtual ~Task() { }
+		virtual void run(size_t) = 0;
+	};
+protected:
+	Task& task;
+	size_t numItems;
+	size_t nextItem;
+	size_t failedItem;
+	Exception failure;
+	pthread_mutex_t lock;
+
+	static void* worker(void*);
+	bool next(size_t&);
+	void fail(size_t, Exception const&);
+
+	WorkQueue(Task&, size_t);
+	~WorkQueue();
+public:
+	static unsigned int numThreads();
+	static void run(Task&, size_t, unsigned int = 0);
+};
+
+#endif
@@ -0,0 +1,226 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "BakedModel.h"
+#include "Exception.h"
+#include <math.h>
+#include <string.h>
+
+namespace {
+	/* Half the width of a voxel cube as VoxelRenderer draws it with pitch 0.
+	 * The cube's half size is (1 - pitch) / 2, so with a positive pitch the
+	 * bounds are slightly larger than they need to be, never too small
+	 */
+	float const voxelRadius = 0.5f;
+
+	void transformPoint(float const* m, float x, float y, float z, float* out) {
+		out[0] = m[0] * x + m[4] * y + m[8] * z + m[12];
+		out[1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+		out[2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+	}
+}
+
+BakedModel::BakedModel(VXLFile& vxl, HVAFile* hva, uint32_t stepsPerFrame, bool withCentres) :
+		frames(1), steps(stepsPerFrame), limbs(vxl.getNumLimbs()), totalVoxels(0) {
+	if(steps == 0) {
+		throw EXCEPTION("Need at least one step per frame");
+	}
+	if(hva != NULL && hva->numFrames() != 0) {
+		frames = hva->numFrames() * steps;
+	}
+
+	/* Pull the voxels out of the spans once, in the order the renderer walks
+	 * them
+	 */
+	limbVoxels.resize(limbs + 1);
+	sectionScale.resize(limbs * 3);
+	for(uint32_t i = 0; i != limbs; i++) {
+		vxl.setCurrentLimb(i);
+		uint8_t xs, ys, zs;
+		float min[3], max[3];
+		vxl.getSize(xs, ys, zs);
+		vxl.getBounds(min, max);
+		sectionScale[i * 3]     = (max[0] - min[0]) / (float)xs;
+		sectionScale[i * 3 + 1] = (max[1] - min[1]) / (float)ys;
+		sectionScale[i * 3 + 2] = (max[2] - min[2]) / (float)zs;
+
+		limbVoxels[i] = voxels.size();
+		VXLFile::LimbBody::Span::Voxel vx;
+		for(unsigned int x = 0; x != xs; x++) {
+			for(unsigned int y = 0; y != ys; y++) {
+				for(unsigned int z = 0; z != zs; z++) {
+					if(vxl.getVoxel(x, y, z, &vx)) {
+						Voxel v = { static_cast<uint8_t>(x), static_cast<uint8_t>(y), static_cast<uint8_t>(z), vx.colour, vx.normal };
+						voxels.push_back(v);
+					}
+				}
+			}
+		}
+	}
+	limbVoxels[limbs] = voxels.size();
+	totalVoxels = voxels.size();
+
+	bakeTransforms(vxl, hva);
+	bakeBounds();
+	if(withCentres) {
+		bakeCentres();
+	}
+}
+
+void BakedModel::bakeTransforms(VXLFile& vxl, HVAFile* hva) {
+	std::vector<uint32_t> binding(limbs);
+	std::vector<float> sampled;
+	bool animated = hva != NULL && hva->numFrames() != 0;
+	if(animated) {
+		for(uint32_t i = 0; i != limbs; i++) {
+			vxl.setCurrentLimb(i);
+			binding[i] = hva->findSection(vxl.limbName());
+		}
+		sampled.resize(hva->numSections() * 16);
+	}
+
+	transforms.resize(frames * limbs * 16);
+	for(uint32_t f = 0; f != frames; f++) {
+		if(animated) {
+			hva->sampleAll(static_cast<float>(f) / static_cast<float>(steps), &sampled[0]);
+		}
+		for(uint32_t i = 0; i != limbs; i++) {
+			vxl.setCurrentLimb(i);
+			float* m = &transforms[(f * limbs + i) * 16];
+			float const* s = getSectionScale(i);
+			/* The same as VoxelRenderer::renderSection */
+			if(animated) {
+				memcpy(m, &sampled[binding[i] * 16], 16 * sizeof(float));
+				m[12] *= vxl.getScale() * s[0];
+				m[13] *= vxl.getScale() * s[1];
+				m[14] *= vxl.getScale() * s[2];
+			} else {
+				vxl.loadGLMatrix(m);
+			}
+			/* Then translated to the bottom left of the bounding box */
+			float min[3], max[3];
+			vxl.getBounds(min, max);
+			float t[3];
+			transformPoint(m, min[0], min[1], min[2], t);
+			m[12] = t[0];
+			m[13] = t[1];
+			m[14] = t[2];
+		}
+	}
+}
+
+void BakedModel::bakeBounds() {
+	/* The corners of the box around each limb's voxels are enough, the cubes
+	 * can't reach outside it whatever the transform
+	 */
+	std::vector<float> lo(limbs * 3), hi(limbs * 3);
+	std::vector<bool> empty(limbs);
+	for(uint32_t i = 0; i != limbs; i++) {
+		empty[i] = limbVoxels[i] == limbVoxels[i + 1];
+		if(empty[i]) {
+			continue;
+		}
+		uint8_t vmin[3] = { 255, 255, 255 }, vmax[3] = { 0, 0, 0 };
+		for(size_t v = limbVoxels[i]; v != limbVoxels[i + 1]; v++) {
+			uint8_t const c[3] = { voxels[v].x, voxels[v].y, voxels[v].z };
+			for(int a = 0; a != 3; a++) {
+				vmin[a] = c[a] < vmin[a] ? c[a] : vmin[a];
+				vmax[a] = c[a] > vmax[a] ? c[a] : vmax[a];
+			}
+		}
+		float const* s = getSectionScale(i);
+		for(int a = 0; a != 3; a++) {
+			lo[i * 3 + a] = vmin[a] * s[a] - voxelRadius;
+			hi[i * 3 + a] = vmax[a] * s[a] + voxelRadius;
+		}
+	}
+
+	bounds.assign(frames * 6, 0);
+	for(uint32_t f = 0; f != frames; f++) {
+		float* b = &bounds[f * 6];
+		bool first = true;
+		for(uint32_t i = 0; i != limbs; i++) {
+			if(empty[i]) {
+				continue;
+			}
+			float const* m = getTransform(f, i);
+			for(int c = 0; c != 8; c++) {
+				float p[3];
+				transformPoint(m, (c & 1) ? hi[i * 3] : lo[i * 3], (c & 2) ? hi[i * 3 + 1] : lo[i * 3 + 1],
+					(c & 4) ? hi[i * 3 + 2] : lo[i * 3 + 2], p);
+				for(int a = 0; a != 3; a++) {
+					if(first || p[a] < b[a]) {
+						b[a] = p[a];
+					}
+					if(first || p[a] > b[a + 3]) {
+						b[a + 3] = p[a];
+					}
+				}
+				first = false;
+			}
+		}
+	}
+}
+
+void BakedModel::bakeCentres() {
+	centres.resize(frames * totalVoxels * 3);
+	for(uint32_t f = 0; f != frames; f++) {
+		float* out = &centres[f * totalVoxels * 3];
+		for(uint32_t i = 0; i != limbs; i++) {
+			float const* m = getTransform(f, i);
+			float const* s = getSectionScale(i);
+			for(size_t v = limbVoxels[i]; v != limbVoxels[i + 1]; v++, out += 3) {
+				transformPoint(m, voxels[v].x * s[0], voxels[v].y * s[1], voxels[v].z * s[2], out);
+			}
+		}
+	}
+}
+
+uint32_t BakedModel::getFrame(float time) const {
+	float t = fmodf(time * static_cast<float>(steps), static_cast<float>(frames));
+	if(t < 0) {
+		t += static_cast<float>(frames);
+	}
+	uint32_t frame = static_cast<uint32_t>(t);
+	return frame < frames ? frame : 0;
+}
+
+BakedModel::Voxel const* BakedModel::getVoxels(uint32_t limb, size_t& n) const {
+	if(limb >= limbs) {
+		throw EXCEPTION("Limb %u is too large (numLimbs == %u)", limb, limbs);
+	}
+	n = limbVoxels[limb + 1] - limbVoxels[limb];
+	return n != 0 ? &voxels[limbVoxels[limb]] : NULL;
+}
+
+float const* BakedModel::getCentres(uint32_t frame, uint32_t limb) const {
+	if(limb >= limbs) {
+		throw EXCEPTION("Limb %u is too large (numLimbs == %u)", limb, limbs);
+	}
+	if(centres.empty() || limbVoxels[limb] == limbVoxels[limb + 1]) {
+		return NULL;
+	}
+	return &centres[(frame * totalVoxels + limbVoxels[limb]) * 3];
+}
+
+size_t BakedModel::bakedSize() const {
+	return (transforms.size() + bounds.size() + sectionScale.size() + centres.size()) * sizeof(float) +
+		voxels.size() * sizeof(Voxel) + limbVoxels.size() * sizeof(size_t);
+}
@@ -20,18 +20,249 @@
 #include "Base64.h"
 #include "Exception.h"
 #include "Utils.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <vector>
 
-void Base64::initialiseTable() {
-	static bool initialised = false;
-	if(initialised) {
-		return;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#	define BASE64_X86
+#	include <immintrin.h>
+#endif
+
+int const Base64::Scalar = 0;
+int const Base64::SSSE3 = 1;
+int const Base64::AVX2 = 2;
+
+int Base64::implementation = Base64::Scalar;
+Base64::BlockDecoder Base64::blockDecoder = &Base64::decodeBlocksScalar;
+Base64::BlockEncoder Base64::blockEncoder = NULL;
+
+#ifdef BASE64_X86
+/* The vector decoders are based on the pshufb lookup described by Wojciech
+ * Mula and Daniel Lemire ("Faster Base64 Encoding and Decoding using AVX2
+ * Instructions").  Each block is classified by its high and low nibbles;
+ * any character outside the alphabet (including '=') makes the block
+ * invalid, at which point the vector loop stops and the scalar code takes
+ * over, so padding and error reporting behave exactly as before.
+ *
+ * Every store writes a full register but only 3/4 of it is output, so the
+ * loops stop while there is still enough input left that the excess lands
+ * in space the following quads will overwrite.  That also makes decoding in
+ * place safe, the output never overtakes the block just loaded.
+ */
+namespace {
+	__attribute__((target("ssse3")))
+	size_t decodeBlocksSSSE3(uint8_t const* in, uint8_t* out, size_t len) {
+		__m128i const lutLo = _mm_setr_epi8(
+			0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+			0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+		__m128i const lutHi = _mm_setr_epi8(
+			0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+		__m128i const lutRoll = _mm_setr_epi8(
+			0, 16, 19, 4, -65, -65, -71, -71,
+			0, 0, 0, 0, 0, 0, 0, 0);
+		__m128i const mask2F = _mm_set1_epi8(0x2F);
+		__m128i const zero = _mm_setzero_si128();
+		__m128i const pack = _mm_setr_epi8(
+			2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+		size_t pos = 0;
+		while(len - pos >= 16 + 8) {
+			__m128i str = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + pos));
+			__m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask2F);
+			__m128i loNibbles = _mm_and_si128(str, mask2F);
+			__m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+			__m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+			if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), zero)) != 0xFFFF) {
+				break;
+			}
+			__m128i eq2F = _mm_cmpeq_epi8(str, mask2F);
+			__m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles));
+			str = _mm_add_epi8(str, roll);
+			/* Merge the 6 bit values into 24 bit groups, then drop the gaps */
+			str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+			str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+			str = _mm_shuffle_epi8(str, pack);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + (pos / 4) * 3), str);
+			pos += 16;
+		}
+		return pos;
 	}
+
+	__attribute__((target("avx2")))
+	size_t decodeBlocksAVX2(uint8_t const* in, uint8_t* out, size_t len) {
+		__m256i const lutLo = _mm256_setr_epi8(
+			0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+			0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+			0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+			0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+		__m256i const lutHi = _mm256_setr_epi8(
+			0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+		__m256i const lutRoll = _mm256_setr_epi8(
+			0, 16, 19, 4, -65, -65, -71, -71,
+			0, 0, 0, 0, 0, 0, 0, 0,
+			0, 16, 19, 4, -65, -65, -71, -71,
+			0, 0, 0, 0, 0, 0, 0, 0);
+		__m256i const mask2F = _mm256_set1_epi8(0x2F);
+		__m256i const pack = _mm256_setr_epi8(
+			2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+			2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+		__m256i const lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+		size_t pos = 0;
+		while(len - pos >= 32 + 12) {
+			__m256i str = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + pos));
+			__m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask2F);
+			__m256i loNibbles = _mm256_and_si256(str, mask2F);
+			__m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+			__m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+			if(!_mm256_testz_si256(lo, hi)) {
+				break;
+			}
+			__m256i eq2F = _mm256_cmpeq_epi8(str, mask2F);
+			__m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(eq2F, hiNibbles));
+			str = _mm256_add_epi8(str, roll);
+			str = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+			str = _mm256_madd_epi16(str, _mm256_set1_epi32(0x00011000));
+			str = _mm256_shuffle_epi8(str, pack);
+			str = _mm256_permutevar8x32_epi32(str, lanes);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + (pos / 4) * 3), str);
+			pos += 32;
+		}
+		return pos;
+	}
+
+	/* Encoding uses the multiply based bit shuffle and pshufb translation
+	 * from the same authors.  Each block reads 16 (or 32) bytes but only
+	 * encodes 12 (or 24) of them, so the loops stop before reading past the
+	 * end of the input
+	 */
+	__attribute__((target("ssse3")))
+	__m128i encodeTranslate(__m128i indices) {
+		__m128i const shiftLUT = _mm_setr_epi8(
+			'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+			'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+			'/' - 63, 'A', 0, 0);
+		__m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+		__m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+		result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+		return _mm_add_epi8(_mm_shuffle_epi8(shiftLUT, result), indices);
+	}
+
+	__attribute__((target("ssse3")))
+	size_t encodeBlocksSSSE3(uint8_t const* in, uint8_t* out, size_t len) {
+		__m128i const spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+		size_t pos = 0;
+		while(len - pos >= 16) {
+			__m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(in + pos)), spread);
+			__m128i t0 = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+			__m128i t1 = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + (pos / 3) * 4), encodeTranslate(_mm_or_si128(t0, t1)));
+			pos += 12;
+		}
+		return pos;
+	}
+
+	__attribute__((target("avx2")))
+	size_t encodeBlocksAVX2(uint8_t const* in, uint8_t* out, size_t len) {
+		__m256i const spread = _mm256_set_epi8(
+			10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+			10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+		__m256i const shiftLUT = _mm256_setr_epi8(
+			'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+			'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+			'/' - 63, 'A', 0, 0,
+			'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+			'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+			'/' - 63, 'A', 0, 0);
+		size_t pos = 0;
+		while(len - pos >= 12 + 16) {
+			__m256i v = _mm256_inserti128_si256(
+				_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const*>(in + pos))),
+				_mm_loadu_si128(reinterpret_cast<__m128i const*>(in + pos + 12)), 1);
+			v = _mm256_shuffle_epi8(v, spread);
+			__m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(v, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+			__m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(v, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+			__m256i indices = _mm256_or_si256(t0, t1);
+			__m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+			__m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+			result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+			result = _mm256_add_epi8(_mm256_shuffle_epi8(shiftLUT, result), indices);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + (pos / 3) * 4), result);
+			pos += 24;
+		}
+		return pos;
+	}
+}
+#endif
+
+void Base64::initialiseTable() {
 	DEBUG("Intialising Base64 table");
 	for(unsigned int i = 0; i != 64; i++) {
 		lookup[alphabet[i]] = i;
+		strictLookup[alphabet[i]] = i;
 	}
 	lookup['='] = 0;
-	initialised = true;
+	if(isSupported(AVX2)) {
+		selectImplementation(AVX2);
+	} else if(isSupported(SSSE3)) {
+		selectImplementation(SSSE3);
+	}
+}
+
+void Base64::initialise() {
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+	pthread_once(&once, &initialiseTable);
+}
+
+void Base64::selectImplementation(int impl) {
+	implementation = impl;
+	if(impl == Scalar) {
+		blockDecoder = &decodeBlocksScalar;
+		blockEncoder = NULL;
+#ifdef BASE64_X86
+	} else if(impl == SSSE3) {
+		blockDecoder = &decodeBlocksSSSE3;
+		blockEncoder = &encodeBlocksSSSE3;
+	} else if(impl == AVX2) {
+		blockDecoder = &decodeBlocksAVX2;
+		blockEncoder = &encodeBlocksAVX2;
+#endif
+	}
+}
+
+bool Base64::isSupported(int impl) {
+	if(impl == Scalar) {
+		return true;
+	}
+#ifdef BASE64_X86
+	__builtin_cpu_init();
+	if(impl == SSSE3) {
+		return __builtin_cpu_supports("ssse3");
+	}
+	if(impl == AVX2) {
+		return __builtin_cpu_supports("avx2");
+	}
+#endif
+	return false;
+}
+
+/* Normally the fastest supported implementation is picked automatically,
+ * this is for benchmarking and testing
+ */
+void Base64::setImplementation(int impl) {
+	initialise();
+	if(!isSupported(impl)) {
+		throw EXCEPTION("Base64 implementation %i is not supported on this CPU", impl);
+	}
+	selectImplementation(impl);
+}
+
+int Base64::getImplementation() {
+	initialise();
+	return implementation;
 }
 
 unsigned int Base64::decode64Chunk(uint8_t const* in, uint8_t* out) {
@@ -66,32 +297,152 @@ unsigned int Base64::decode64Chunk(uint8_t const* in, uint8_t* out) {
 	return bytes;
 }
 
-size_t Base64::decode(uint8_t const* in, uint8_t* out, size_t len) {
-	initialiseTable();
-	uint8_t const* b64Pos = in;
-	uint8_t* decPos = out;
-	unsigned int num;
-	if(len % 4 != 0) {
-		throw EXCEPTION("Base64 encoded data must be a multiple of 4 bytes long, this buffer is %u long", len);
+/* Decodes whole quads while they are all plain alphabet characters, the
+ * first quad containing padding or anything invalid is left for
+ * decode64Chunk.  Returns the number of input bytes consumed
+ */
+size_t Base64::decodeBlocksScalar(uint8_t const* in, uint8_t* out, size_t len) {
+	size_t pos = 0;
+	while(len - pos > 4) {
+		uint32_t a = strictLookup[in[pos]];
+		uint32_t b = strictLookup[in[pos + 1]];
+		uint32_t c = strictLookup[in[pos + 2]];
+		uint32_t d = strictLookup[in[pos + 3]];
+		if((a | b | c | d) & 0xC0) {
+			break;
+		}
+		uint32_t accum = (a << 18) | (b << 12) | (c << 6) | d;
+		out[0] = accum >> 16;
+		out[1] = accum >> 8;
+		out[2] = accum;
+		out += 3;
+		pos += 4;
+	}
+	return pos;
+}
+
+/* Decodes len bytes (a non-zero multiple of 4) returning the number of bytes
+ * the last quad decoded to.  Quads before the last always advance the output
+ * by 3 bytes
+ */
+unsigned int Base64::decodeQuads(uint8_t const* in, uint8_t* out, size_t len) {
+	/* The vector decoders leave a tail for the scalar loop, which in turn
+	 * always leaves at least the last quad for decode64Chunk
+	 */
+	size_t done = blockDecoder(in, out, len);
+	if(blockDecoder != &decodeBlocksScalar) {
+		done += decodeBlocksScalar(in + done, out + (done / 4) * 3, len - done);
 	}
+	uint8_t const* b64Pos = in + done;
+	uint8_t* decPos = out + (done / 4) * 3;
+	unsigned int num = 3;
 	while(b64Pos != in + len) {
 		num = decode64Chunk(b64Pos, decPos);
 		b64Pos += 4;
 		decPos += 3;
 	}
-	return decPos - out - (3 - num);
+	return num;
+}
+
+size_t Base64::decode(uint8_t const* in, uint8_t* out, size_t len) {
+	initialise();
+	if(len % 4 != 0) {
+		throw EXCEPTION("Base64 encoded data must be a multiple of 4 bytes long, this buffer is %u long", len);
+	}
+	if(len == 0) {
+		return 0;
+	}
+	unsigned int num = decodeQuads(in, out, len);
+	return (len / 4) * 3 - (3 - num);
 }
 
+size_t Base64::encodedSize(size_t len) {
+	return ((len + 2) / 3) * 4;
+}
+
+/* Writes encodedSize(len) bytes, padded with '=' as needed.  in and out must
+ * not overlap
+ */
+size_t Base64::encode(uint8_t const* in, size_t len, uint8_t* out) {
+	initialise();
+	size_t done = blockEncoder != NULL ? blockEncoder(in, out, len) : 0;
+	uint8_t* encPos = out + (done / 3) * 4;
+	for(; len - done >= 3; done += 3) {
+		uint32_t accum = (in[done] << 16) | (in[done + 1] << 8) | in[done + 2];
+		encPos[0] = alphabet[accum >> 18];
+		encPos[1] = alphabet[(accum >> 12) & 0x3F];
+		encPos[2] = alphabet[(accum >> 6) & 0x3F];
+		encPos[3] = alphabet[accum & 0x3F];
+		encPos += 4;
+	}
+	if(done != len) {
+		uint32_t accum = in[done] << 16;
+		if(len - done == 2) {
+			accum |= in[done + 1] << 8;
+		}
+		encPos[0] = alphabet[accum >> 18];
+		encPos[1] = alphabet[(accum >> 12) & 0x3F];
+		encPos[2] = len - done == 2 ? alphabet[(accum >> 6) & 0x3F] : '=';
+		encPos[3] = '=';
+		encPos += 4;
+	}
+	return encPos - out;
+}
+
+/* Decodes the numbered keys "1", "2", ... of the current section as if they
+ * were one string.  Lines are decoded straight from the INIFile's values,
+ * with the odd quad that spans two lines put back together in a small buffer
+ */
 uint8_t* Base64::decode(INIFile& ini, size_t& len) {
-	std::string b64;
-	for(unsigned int key = 1; ini.keyExists(Utils::toString(key)); key++) {
-		b64 += ini.getKey(Utils::toString(key));
+	initialise();
+	std::vector<std::string const*> lines;
+	size_t total = 0;
+	std::string key;
+	char keyBuf[16];
+	for(unsigned int i = 1; ; i++) {
+		key.assign(keyBuf, snprintf(keyBuf, sizeof(keyBuf), "%u", i));
+		std::string const* val = ini.findKey(key);
+		if(val == NULL) {
+			break;
+		}
+		lines.push_back(val);
+		total += val->length();
+	}
+	if(total % 4) {
+		throw EXCEPTION("Data from INI file is not a multiple of 4 bytes long (is %u long)", total);
 	}
-	if(b64.length() % 4) {
-		throw EXCEPTION("Data from INI file is not a multiple of 4 bytes long (is %u long)", b64.length());
+	uint8_t* buf = new uint8_t[(total / 4) * 3];
+	uint8_t* decPos = buf;
+	uint8_t quad[4];
+	unsigned int quadLen = 0;
+	unsigned int num = 3;
+	try {
+		for(size_t i = 0; i != lines.size(); i++) {
+			uint8_t const* in = reinterpret_cast<uint8_t const*>(lines[i]->data());
+			size_t left = lines[i]->length();
+			while(quadLen != 0 && left != 0) {
+				quad[quadLen++] = *in++;
+				left--;
+				if(quadLen == 4) {
+					num = decodeQuads(quad, decPos, 4);
+					decPos += 3;
+					quadLen = 0;
+				}
+			}
+			size_t whole = left & ~static_cast<size_t>(3);
+			if(whole != 0) {
+				num = decodeQuads(in, decPos, whole);
+				decPos += (whole / 4) * 3;
+			}
+			for(; whole != left; whole++) {
+				quad[quadLen++] = in[whole];
+			}
+		}
+	} catch(...) {
+		delete[] buf;
+		throw;
 	}
-	uint8_t* buf = new uint8_t[(b64.length() / 4) * 3];
-	len = decode(reinterpret_cast<uint8_t const*>(b64.c_str()), buf, b64.length());
+	len = total == 0 ? 0 : (decPos - buf) - (3 - num);
 	return buf;
 }
 
@@ -137,3 +488,38 @@ uint8_t Base64::lookup[256] = {
 	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
 	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
 };
+
+uint8_t Base64::strictLookup[256] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
@@ -18,6 +18,133 @@
  */
 
 #include "HVAFile.h"
+#include <math.h>
+
+#ifdef __SSE2__
+#	include <emmintrin.h>
+#endif
+
+uint32_t const HVAFile::numKeyFields = 13;
+
+namespace {
+	/* Fields of each decomposed keyframe in HVAFile::keys.  Theta is the angle
+	 * between this frame's rotation and the next frame's, InvSin is 1 / sin of
+	 * it and Sign is -1 when the next frame's quaternion has to be negated to
+	 * take the short way round
+	 */
+	enum {
+		QX, QY, QZ, QW, TX, TY, TZ, SX, SY, SZ, Theta, InvSin, Sign
+	};
+
+	/* Below this the slerp weights are indistinguishable from a lerp's, so the
+	 * angle is clamped rather than special cased
+	 */
+	float const minTheta = 1e-3f;
+
+	/* Splits a 3x4 matrix into translation, per-axis scale (the length of each
+	 * column, negative on x if the matrix mirrors) and the remaining rotation
+	 * as a unit quaternion
+	 */
+	void decompose(HVAFile::Section::TMatrix const& tm, float* q, float* t, float* s) {
+		float r[3][3];
+		for(int j = 0; j != 3; j++) {
+			s[j] = sqrtf(tm[0][j] * tm[0][j] + tm[1][j] * tm[1][j] + tm[2][j] * tm[2][j]);
+			for(int i = 0; i != 3; i++) {
+				if(s[j] > 0) {
+					r[i][j] = tm[i][j] / s[j];
+				} else {
+					r[i][j] = (i == j) ? 1 : 0;
+				}
+			}
+			t[j] = tm[j][3];
+		}
+		float det = r[0][0] * (r[1][1] * r[2][2] - r[1][2] * r[2][1])
+			- r[0][1] * (r[1][0] * r[2][2] - r[1][2] * r[2][0])
+			+ r[0][2] * (r[1][0] * r[2][1] - r[1][1] * r[2][0]);
+		if(det < 0) {
+			s[0] = -s[0];
+			r[0][0] = -r[0][0];
+			r[1][0] = -r[1][0];
+			r[2][0] = -r[2][0];
+		}
+
+		/* Work from the largest diagonal term to keep the division stable */
+		float trace = r[0][0] + r[1][1] + r[2][2];
+		if(trace > 0) {
+			float d = sqrtf(trace + 1) * 2;
+			q[0] = (r[2][1] - r[1][2]) / d;
+			q[1] = (r[0][2] - r[2][0]) / d;
+			q[2] = (r[1][0] - r[0][1]) / d;
+			q[3] = d / 4;
+		} else if(r[0][0] > r[1][1] && r[0][0] > r[2][2]) {
+			float d = sqrtf(1 + r[0][0] - r[1][1] - r[2][2]) * 2;
+			q[0] = d / 4;
+			q[1] = (r[0][1] + r[1][0]) / d;
+			q[2] = (r[0][2] + r[2][0]) / d;
+			q[3] = (r[2][1] - r[1][2]) / d;
+		} else if(r[1][1] > r[2][2]) {
+			float d = sqrtf(1 + r[1][1] - r[0][0] - r[2][2]) * 2;
+			q[0] = (r[0][1] + r[1][0]) / d;
+			q[1] = d / 4;
+			q[2] = (r[1][2] + r[2][1]) / d;
+			q[3] = (r[0][2] - r[2][0]) / d;
+		} else {
+			float d = sqrtf(1 + r[2][2] - r[0][0] - r[1][1]) * 2;
+			q[0] = (r[0][2] + r[2][0]) / d;
+			q[1] = (r[1][2] + r[2][1]) / d;
+			q[2] = d / 4;
+			q[3] = (r[1][0] - r[0][1]) / d;
+		}
+		float len = 1 / sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+		for(int i = 0; i != 4; i++) {
+			q[i] *= len;
+		}
+	}
+
+	/* Rebuilds the matrix from the decomposed parts, in the layout
+	 * HVAFile::loadGLMatrix uses
+	 */
+	void compose(float const* q, float const* t, float const* s, float* m) {
+		float xx = q[0] * q[0], yy = q[1] * q[1], zz = q[2] * q[2];
+		float xy = q[0] * q[1], xz = q[0] * q[2], yz = q[1] * q[2];
+		float wx = q[3] * q[0], wy = q[3] * q[1], wz = q[3] * q[2];
+		m[0]  = (1 - 2 * (yy + zz)) * s[0];
+		m[1]  = 2 * (xy + wz) * s[0];
+		m[2]  = 2 * (xz - wy) * s[0];
+		m[3]  = 0;
+		m[4]  = 2 * (xy - wz) * s[1];
+		m[5]  = (1 - 2 * (xx + zz)) * s[1];
+		m[6]  = 2 * (yz + wx) * s[1];
+		m[7]  = 0;
+		m[8]  = 2 * (xz + wy) * s[2];
+		m[9]  = 2 * (yz - wx) * s[2];
+		m[10] = (1 - 2 * (xx + yy)) * s[2];
+		m[11] = 0;
+		m[12] = t[0];
+		m[13] = t[1];
+		m[14] = t[2];
+		m[15] = 1;
+	}
+
+#ifdef __SSE2__
+	/* sin(x) for x in [0, pi/2], which is all slerp needs once the short way
+	 * round has been picked.  Taylor series to x^9, within 4e-6
+	 */
+	__m128 sin4(__m128 x) {
+		__m128 x2 = _mm_mul_ps(x, x);
+		__m128 p = _mm_set1_ps(1.0f / 362880);
+		p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-1.0f / 5040));
+		p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(1.0f / 120));
+		p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-1.0f / 6));
+		p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(1));
+		return _mm_mul_ps(p, x);
+	}
+
+	__m128 lerp4(__m128 a, __m128 b, __m128 t) {
+		return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+	}
+#endif
+}
 
 HVAFile::HVAFile(std::string const& file) : sections(NULL), currentSection(0) {
 	FILE* f = fopen(file.c_str(), "rb");
@@ -48,27 +175,83 @@ HVAFile::HVAFile(std::string const& file) : sections(NULL), currentSection(0) {
 			fixed.read(&sections[j].matrices[i]);
 		}
 	}
+	buildGLMatrices();
+	buildKeys();
 }
 
 HVAFile::~HVAFile() {
 	delete[] sections;
 }
 
-void HVAFile::setCurrentSection(std::string const& name) {
+void HVAFile::buildKeys() {
+	keyStride = (header.numSections + 3) & ~3u;
+	keys.resize(header.numFrames * numKeyFields * keyStride);
+	for(uint32_t i = 0; i != header.numFrames; i++) {
+		float* k = &keys[i * numKeyFields * keyStride];
+		for(uint32_t j = 0; j != keyStride; j++) {
+			float q[4] = { 0, 0, 0, 1 };
+			float t[3] = { 0, 0, 0 };
+			float s[3] = { 1, 1, 1 };
+			/* The padding sections get an identity so sampleAll's spare lanes
+			 * stay finite
+			 */
+			if(j < header.numSections) {
+				decompose(sections[j].matrices[i], q, t, s);
+			}
+			for(int f = 0; f != 4; f++) {
+				k[(QX + f) * keyStride + j] = q[f];
+			}
+			for(int f = 0; f != 3; f++) {
+				k[(TX + f) * keyStride + j] = t[f];
+				k[(SX + f) * keyStride + j] = s[f];
+			}
+		}
+	}
+	for(uint32_t i = 0; i != header.numFrames; i++) {
+		float* k0 = &keys[i * numKeyFields * keyStride];
+		float* k1 = &keys[((i + 1) % header.numFrames) * numKeyFields * keyStride];
+		for(uint32_t j = 0; j != keyStride; j++) {
+			float dot = 0;
+			for(int f = 0; f != 4; f++) {
+				dot += k0[(QX + f) * keyStride + j] * k1[(QX + f) * keyStride + j];
+			}
+			float theta = acosf(fminf(fabsf(dot), 1));
+			if(theta < minTheta) {
+				theta = minTheta;
+			}
+			k0[Theta * keyStride + j] = theta;
+			k0[InvSin * keyStride + j] = 1 / sinf(theta);
+			k0[Sign * keyStride + j] = (dot < 0) ? -1 : 1;
+		}
+	}
+}
+
+uint32_t HVAFile::findSection(std::string const& name) const {
 	for(uint32_t i = 0; i != header.numSections; i++) {
 		if(strcmp(reinterpret_cast<char const*>(&sections[i].name[0]), name.c_str()) == 0) {
-			currentSection = i;
-			return;
+			return i;
 		}
 	}
 	throw EXCEPTION("Could not find section with name \"%s\"", name.c_str());
 }
 
+std::string HVAFile::getSectionName(uint32_t section) const {
+	if(section >= header.numSections) {
+		throw EXCEPTION("Section %u is out of range (there are only %u sections)", section, header.numSections);
+	}
+	char const* name = reinterpret_cast<char const*>(&sections[section].name[0]);
+	return std::string(name, strnlen(name, sizeof(sections[section].name)));
+}
+
+void HVAFile::setCurrentSection(std::string const& name) {
+	currentSection = findSection(name);
+}
+
 uint32_t HVAFile::numFrames() {
 	return header.numFrames;
 }
 
-void HVAFile::loadGLMatrix(uint32_t frame, float* m) {
+void HVAFile::buildGLMatrices() {
 	/* OpenGL matrices are laid out thus:
 	 * [ 0] [ 4] [ 8] [12]
 	 * [ 1] [ 5] [ 9] [13]
@@ -81,26 +264,152 @@ void HVAFile::loadGLMatrix(uint32_t frame, float* m) {
 	 * [2][0] [2][1] [2][2] [2][3]
 	 *    0      0      0      1
 	 */
+	glMatrices.resize(header.numFrames * header.numSections * 16);
+	float* m = glMatrices.empty() ? NULL : &glMatrices[0];
+	for(uint32_t i = 0; i != header.numFrames; i++) {
+		for(uint32_t j = 0; j != header.numSections; j++, m += 16) {
+			Section::TMatrix const& tm = sections[j].matrices[i];
+			for(int c = 0; c != 4; c++) {
+				m[c * 4]     = tm[0][c];
+				m[c * 4 + 1] = tm[1][c];
+				m[c * 4 + 2] = tm[2][c];
+				m[c * 4 + 3] = (c == 3) ? 1 : 0;
+			}
+		}
+	}
+}
+
+void HVAFile::loadGLMatrix(uint32_t frame, float* m) {
 	if(frame >= header.numFrames) {
 		throw EXCEPTION("Frame %u is out of range (there are only %u frames)", frame, header.numFrames);
 	}
-	Section::TMatrix* tm = &sections[currentSection].matrices[frame];
-	m[0]  = (*tm)[0][0];
-	m[1]  = (*tm)[1][0];
-	m[2]  = (*tm)[2][0];
-	m[3]  = 0;
-	m[4]  = (*tm)[0][1];
-	m[5]  = (*tm)[1][1];
-	m[6]  = (*tm)[2][1];
-	m[7]  = 0;
-	m[8]  = (*tm)[0][2];
-	m[9]  = (*tm)[1][2];
-	m[10] = (*tm)[2][2];
-	m[11] = 0;
-	m[12] = (*tm)[0][3];
-	m[13] = (*tm)[1][3];
-	m[14] = (*tm)[2][3];
-	m[15] = 1;
+	memcpy(m, getGLMatrix(frame, currentSection), 16 * sizeof(float));
+}
+
+uint32_t HVAFile::splitTime(float time, float& frac) const {
+	if(header.numFrames == 0) {
+		throw EXCEPTION("There are no frames to sample");
+	}
+	float len = static_cast<float>(header.numFrames);
+	time = fmodf(time, len);
+	if(time < 0) {
+		time += len;
+	}
+	uint32_t frame = static_cast<uint32_t>(time);
+	if(frame >= header.numFrames) {
+		/* A tiny negative time can round up to exactly len */
+		frame = 0;
+		time = 0;
+	}
+	frac = time - static_cast<float>(frame);
+	return frame;
+}
+
+void HVAFile::sample(uint32_t section, float time, float* m) const {
+	if(section >= header.numSections) {
+		throw EXCEPTION("Section %u is out of range (there are only %u sections)", section, header.numSections);
+	}
+	float frac;
+	uint32_t frame = splitTime(time, frac);
+	if(frac == 0) {
+		memcpy(m, getGLMatrix(frame, section), 16 * sizeof(float));
+		return;
+	}
+	uint32_t n = keyStride;
+	float const* k0 = getKeys(frame) + section;
+	float const* k1 = getKeys(frame + 1 == header.numFrames ? 0 : frame + 1) + section;
+
+	float theta = k0[Theta * n];
+	float a = sinf((1 - frac) * theta) * k0[InvSin * n];
+	float b = sinf(frac * theta) * k0[InvSin * n] * k0[Sign * n];
+	float q[4], t[3], s[3];
+	float len = 0;
+	for(int i = 0; i != 4; i++) {
+		q[i] = a * k0[(QX + i) * n] + b * k1[(QX + i) * n];
+		len += q[i] * q[i];
+	}
+	len = 1 / sqrtf(len);
+	for(int i = 0; i != 4; i++) {
+		q[i] *= len;
+	}
+	for(int i = 0; i != 3; i++) {
+		t[i] = k0[(TX + i) * n] + frac * (k1[(TX + i) * n] - k0[(TX + i) * n]);
+		s[i] = k0[(SX + i) * n] + frac * (k1[(SX + i) * n] - k0[(SX + i) * n]);
+	}
+	compose(q, t, s, m);
+}
+
+void HVAFile::sampleAll(float time, float* m) const {
+#ifdef __SSE2__
+	float frac;
+	uint32_t frame = splitTime(time, frac);
+	if(frac == 0) {
+		memcpy(m, getGLMatrices(frame), header.numSections * 16 * sizeof(float));
+		return;
+	}
+	uint32_t n = keyStride;
+	float const* k0 = getKeys(frame);
+	float const* k1 = getKeys(frame + 1 == header.numFrames ? 0 : frame + 1);
+	__m128 const t = _mm_set1_ps(frac);
+	__m128 const u = _mm_set1_ps(1 - frac);
+	__m128 const one = _mm_set1_ps(1);
+	__m128 const two = _mm_set1_ps(2);
+
+	/* Four sections per pass, the same maths as sample() but with the
+	 * sections across the lanes
+	 */
+	for(uint32_t j = 0; j < header.numSections; j += 4) {
+		__m128 theta = _mm_loadu_ps(k0 + Theta * n + j);
+		__m128 invSin = _mm_loadu_ps(k0 + InvSin * n + j);
+		__m128 a = _mm_mul_ps(sin4(_mm_mul_ps(u, theta)), invSin);
+		__m128 b = _mm_mul_ps(_mm_mul_ps(sin4(_mm_mul_ps(t, theta)), invSin), _mm_loadu_ps(k0 + Sign * n + j));
+		__m128 q[4];
+		for(int i = 0; i != 4; i++) {
+			q[i] = _mm_add_ps(_mm_mul_ps(a, _mm_loadu_ps(k0 + (QX + i) * n + j)), _mm_mul_ps(b, _mm_loadu_ps(k1 + (QX + i) * n + j)));
+		}
+		__m128 len = _mm_add_ps(_mm_add_ps(_mm_mul_ps(q[0], q[0]), _mm_mul_ps(q[1], q[1])),
+			_mm_add_ps(_mm_mul_ps(q[2], q[2]), _mm_mul_ps(q[3], q[3])));
+		len = _mm_div_ps(one, _mm_sqrt_ps(len));
+		for(int i = 0; i != 4; i++) {
+			q[i] = _mm_mul_ps(q[i], len);
+		}
+		__m128 sx = lerp4(_mm_loadu_ps(k0 + SX * n + j), _mm_loadu_ps(k1 + SX * n + j), t);
+		__m128 sy = lerp4(_mm_loadu_ps(k0 + SY * n + j), _mm_loadu_ps(k1 + SY * n + j), t);
+		__m128 sz = lerp4(_mm_loadu_ps(k0 + SZ * n + j), _mm_loadu_ps(k1 + SZ * n + j), t);
+
+		__m128 xx = _mm_mul_ps(q[0], q[0]), yy = _mm_mul_ps(q[1], q[1]), zz = _mm_mul_ps(q[2], q[2]);
+		__m128 xy = _mm_mul_ps(q[0], q[1]), xz = _mm_mul_ps(q[0], q[2]), yz = _mm_mul_ps(q[1], q[2]);
+		__m128 wx = _mm_mul_ps(q[3], q[0]), wy = _mm_mul_ps(q[3], q[1]), wz = _mm_mul_ps(q[3], q[2]);
+
+		/* Indexed by GL matrix element, 3, 7, 11 and 15 are constant */
+		float out[15][4] __attribute__((aligned(16)));
+		_mm_store_ps(out[0], _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx));
+		_mm_store_ps(out[1], _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx));
+		_mm_store_ps(out[2], _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx));
+		_mm_store_ps(out[4], _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy));
+		_mm_store_ps(out[5], _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy));
+		_mm_store_ps(out[6], _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy));
+		_mm_store_ps(out[8], _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz));
+		_mm_store_ps(out[9], _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz));
+		_mm_store_ps(out[10], _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz));
+		_mm_store_ps(out[12], lerp4(_mm_loadu_ps(k0 + TX * n + j), _mm_loadu_ps(k1 + TX * n + j), t));
+		_mm_store_ps(out[13], lerp4(_mm_loadu_ps(k0 + TY * n + j), _mm_loadu_ps(k1 + TY * n + j), t));
+		_mm_store_ps(out[14], lerp4(_mm_loadu_ps(k0 + TZ * n + j), _mm_loadu_ps(k1 + TZ * n + j), t));
+
+		uint32_t lanes = header.numSections - j < 4 ? header.numSections - j : 4;
+		for(uint32_t l = 0; l != lanes; l++) {
+			float* d = m + (j + l) * 16;
+			for(int e = 0; e != 15; e++) {
+				d[e] = ((e & 3) == 3) ? 0 : out[e][l];
+			}
+			d[15] = 1;
+		}
+	}
+#else
+	for(uint32_t j = 0; j != header.numSections; j++) {
+		sample(j, time, m + j * 16);
+	}
+#endif
 }
 
 void HVAFile::print() {
@@ -18,23 +18,30 @@
  */
 
 #include "INIFile.h"
+#include "Utils.h"
 
+#include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 
 INIFile::INIFile() {
 	currentSection = sections.end();
 }
 
-INIFile::INIFile(std::string const& fn) {
+INIFile::INIFile(std::string const& fn, bool lazy) {
 	currentSection = sections.end();
-	read(fn);
+	read(fn, lazy);
 }
 
 bool INIFile::sectionExists(std::string const& section) const {
-	return sections.find(section) != sections.end();
+	return sections.find(section) != sections.end() || pending.find(section) != pending.end();
 }
 
 void INIFile::setCurrentSection(std::string const& section) {
+	PendingMap::iterator p = pending.find(section);
+	if(p != pending.end()) {
+		loadSection(p);
+	}
 	std::pair<SectionMap::iterator, bool> tmp = sections.insert(std::make_pair(section, Section()));
 	currentSection = tmp.first;
 }
@@ -61,20 +68,35 @@ std::string INIFile::getKey(std::string const& key) const {
 	if(it == currentSection->second.end()) {
 		throw EXCEPTION("Key not found");
 	}
-	return it->second;
+	return it->second.str;
+}
+
+/* Returns NULL rather than throwing if the key does not exist, and doesn't
+ * copy the value
+ */
+std::string const* INIFile::findKey(std::string const& key) const {
+	if(currentSection == sections.end()) {
+		throw EXCEPTION("No current section");
+	}
+	Section::const_iterator it = currentSection->second.find(key);
+	if(it == currentSection->second.end()) {
+		return NULL;
+	}
+	return &it->second.str;
 }
 
 void INIFile::setKey(std::string const& key, std::string const& val) {
 	if(currentSection == sections.end()) {
 		throw EXCEPTION("No current section");
 	}
-	currentSection->second[key] = val;
+	currentSection->second[key] = Value(val);
 }
 
 void INIFile::eraseSection() {
 	if(currentSection == sections.end()) {
 		throw EXCEPTION("No current section");
 	}
+	pending.erase(currentSection->first);
 	sections.erase(currentSection);
 	currentSection = sections.end();
 }
@@ -89,6 +111,230 @@ void INIFile::eraseKey(std::string const& key) {
 	}
 }
 
+INIFile::Value const* INIFile::findValue(std::string const& key) const {
+	if(currentSection == sections.end()) {
+		return NULL;
+	}
+	Section::const_iterator it = currentSection->second.find(key);
+	if(it == currentSection->second.end()) {
+		return NULL;
+	}
+	return &it->second;
+}
+
+namespace {
+	bool isSpace(char c) {
+		return c == ' ' || c == '\t';
+	}
+
+	/* Anything after a value other than whitespace or a ';' comment makes it
+	 * invalid
+	 */
+	bool atEnd(char const* p, char const* end) {
+		while(p != end && isSpace(*p)) {
+			p++;
+		}
+		return p == end || *p == ';';
+	}
+
+	bool parseInt(char const* p, char const* end, int& val) {
+		std::string tmp(p, end);
+		char* stop;
+		errno = 0;
+		long l = strtol(tmp.c_str(), &stop, 10);
+		if(stop == tmp.c_str() || errno == ERANGE || l != static_cast<int>(l)) {
+			return false;
+		}
+		val = l;
+		return atEnd(stop, tmp.c_str() + tmp.length());
+	}
+
+	/* Percentages as used all over rules(md).ini ("50%") come back as fractions */
+	bool parseFloat(char const* p, char const* end, float& val) {
+		std::string tmp(p, end);
+		char* stop;
+		double d = strtod(tmp.c_str(), &stop);
+		if(stop == tmp.c_str()) {
+			return false;
+		}
+		if(*stop == '%') {
+			d /= 100;
+			stop++;
+		}
+		val = d;
+		return atEnd(stop, tmp.c_str() + tmp.length());
+	}
+
+	/* The game only looks at the first character: yes/true/1 or no/false/0 */
+	bool parseBool(char const* p, char const* end, bool& val) {
+		while(p != end && isSpace(*p)) {
+			p++;
+		}
+		if(p == end) {
+			return false;
+		}
+		switch(*p) {
+		case 'y': case 'Y': case 't': case 'T': case '1':
+			val = true;
+			return true;
+		case 'n': case 'N': case 'f': case 'F': case '0':
+			val = false;
+			return true;
+		}
+		return false;
+	}
+
+	/* Calls f for each comma separated item, with surrounding whitespace
+	 * removed.  An empty value is an empty list
+	 */
+	template<typename F>
+	bool forEachItem(std::string const& str, F& f) {
+		char const* p = str.data();
+		char const* end = p + str.length();
+		if(atEnd(p, end)) {
+			return true;
+		}
+		char const* semi = static_cast<char const*>(memchr(p, ';', end - p));
+		if(semi != NULL) {
+			end = semi;
+		}
+		for(;;) {
+			char const* comma = static_cast<char const*>(memchr(p, ',', end - p));
+			char const* itemEnd = comma != NULL ? comma : end;
+			char const* s = p;
+			char const* e = itemEnd;
+			while(s != e && isSpace(*s)) {
+				s++;
+			}
+			while(e != s && isSpace(e[-1])) {
+				e--;
+			}
+			if(!f(s, e)) {
+				return false;
+			}
+			if(comma == NULL) {
+				return true;
+			}
+			p = comma + 1;
+		}
+	}
+
+	struct IntItem {
+		std::vector<int>& out;
+		IntItem(std::vector<int>& o) : out(o) { }
+		bool operator()(char const* s, char const* e) {
+			int v;
+			if(!parseInt(s, e, v)) {
+				return false;
+			}
+			out.push_back(v);
+			return true;
+		}
+	};
+
+	struct StringItem {
+		std::vector<std::string>& out;
+		StringItem(std::vector<std::string>& o) : out(o) { }
+		bool operator()(char const* s, char const* e) {
+			out.push_back(std::string(s, e));
+			return true;
+		}
+	};
+}
+
+/* The typed getters return false if there is no current section, the key is
+ * missing or the value doesn't parse, leaving val alone.  Results (including
+ * failures) are kept in the value so repeated queries don't parse again
+ */
+bool INIFile::getInt(std::string const& key, int& val) const {
+	Value const* v = findValue(key);
+	if(v == NULL) {
+		return false;
+	}
+	if(!(v->flags & Value::IntDone)) {
+		v->flags |= Value::IntDone;
+		if(parseInt(v->str.data(), v->str.data() + v->str.length(), v->intVal)) {
+			v->flags |= Value::IntOk;
+		}
+	}
+	if(v->flags & Value::IntOk) {
+		val = v->intVal;
+		return true;
+	}
+	return false;
+}
+
+bool INIFile::getFloat(std::string const& key, float& val) const {
+	Value const* v = findValue(key);
+	if(v == NULL) {
+		return false;
+	}
+	if(!(v->flags & Value::FloatDone)) {
+		v->flags |= Value::FloatDone;
+		if(parseFloat(v->str.data(), v->str.data() + v->str.length(), v->floatVal)) {
+			v->flags |= Value::FloatOk;
+		}
+	}
+	if(v->flags & Value::FloatOk) {
+		val = v->floatVal;
+		return true;
+	}
+	return false;
+}
+
+bool INIFile::getBool(std::string const& key, bool& val) const {
+	Value const* v = findValue(key);
+	if(v == NULL) {
+		return false;
+	}
+	if(!(v->flags & Value::BoolDone)) {
+		v->flags |= Value::BoolDone;
+		if(parseBool(v->str.data(), v->str.data() + v->str.length(), v->boolVal)) {
+			v->flags |= Value::BoolOk;
+		}
+	}
+	if(v->flags & Value::BoolOk) {
+		val = v->boolVal;
+		return true;
+	}
+	return false;
+}
+
+bool INIFile::getIntList(std::string const& key, std::vector<int>& val) const {
+	Value const* v = findValue(key);
+	if(v == NULL) {
+		return false;
+	}
+	if(!(v->flags & Value::IntListDone)) {
+		v->flags |= Value::IntListDone;
+		IntItem f(v->intList);
+		if(forEachItem(v->str, f)) {
+			v->flags |= Value::IntListOk;
+		} else {
+			v->intList.clear();
+		}
+	}
+	if(v->flags & Value::IntListOk) {
+		val = v->intList;
+		return true;
+	}
+	return false;
+}
+
+bool INIFile::getStringList(std::string const& key, std::vector<std::string>& val) const {
+	Value const* v = findValue(key);
+	if(v == NULL) {
+		return false;
+	}
+	if(!(v->flags & Value::StringListDone)) {
+		v->flags |= Value::StringListDone;
+		StringItem f(v->stringList);
+		forEachItem(v->str, f);
+	}
+	val = v->stringList;
+	return true;
+}
+
 void INIFile::write(std::string const& fn) const {
 	FILE* f = fopen(fn.c_str(), "w");
 	if(f == NULL) {
@@ -99,12 +345,20 @@ void INIFile::write(std::string const& fn) const {
 }
 
 void INIFile::write(FILE* f) const {
+	loadAll();
+	Utils::BufferedWrite out(f);
 	for(SectionMap::const_iterator it = sections.begin(); it != sections.end(); it++) {
-		fprintf(f, "[%s]\n", it->first.c_str());
+		out.write('[');
+		out.write(it->first);
+		out.write("]\n", 2);
 		for(Section::const_iterator jt = it->second.begin(); jt != it->second.end(); jt++) {
-			fprintf(f, "%s = %s\n", jt->first.c_str(), jt->second.c_str());
+			out.write(jt->first);
+			out.write(" = ", 3);
+			out.write(jt->second.str);
+			out.write('\n');
 		}
 	}
+	out.flush();
 }
 
 bool INIFile::parseIniLine(char const* line) {
@@ -135,51 +389,231 @@ bool INIFile::parseIniLine(char const* line) {
 		}
 		val.assign(pos + 1);
 		if(trim(val, " \t")) {
-			currentSection->second.insert(make_pair(key, ""));
+			currentSection->second.insert(make_pair(key, Value()));
 		} else {
-			currentSection->second.insert(make_pair(key, val));
+			currentSection->second.insert(make_pair(key, Value(val)));
 		}
 	}
 	return false;
 }
 
-void INIFile::read(std::string const& fn) {
+void INIFile::read(std::string const& fn, bool lazy) {
 	FILE* f = fopen(fn.c_str(), "r");
 	if(f == NULL) {
 		throw EXCEPTION("Could not open file");
 	}
-	read(f);
+	try {
+		read(f, lazy);
+	} catch(...) {
+		fclose(f);
+		throw;
+	}
 	fclose(f);
 }
 
-void INIFile::read(FILE* f) {
-	char buf[1024];
+/* In lazy mode the file is only scanned for section headers here, each
+ * section's keys are parsed the first time it is selected (or all of them
+ * once the sections are iterated or written)
+ */
+void INIFile::read(FILE* f, bool lazy) {
+	char buf[4096];
+	size_t sz;
+	/* Anything still pending refers to the old text */
+	loadAll();
+	text.clear();
+	while((sz = fread(buf, 1, sizeof(buf), f))) {
+		text.append(buf, sz);
+	}
+	parseRead(lazy);
+}
+
+/* For callers that already have the file in memory (e.g. to hash it) */
+void INIFile::read(char const* data, size_t len, bool lazy) {
+	loadAll();
+	text.assign(data, len);
+	parseRead(lazy);
+}
+
+void INIFile::parseRead(bool lazy) {
+	if(lazy) {
+		scanSections();
+	} else {
+		parseText(text.data(), text.length());
+		std::string().swap(text);
+	}
+}
+
+void INIFile::parseText(char const* p, size_t len) {
 	char line[1024];
-	char *bufp;
 	char* linep = &line[0];
 	char* linee = &line[sizeof(line) - 1];
 	bool stripws = true;
-	ssize_t cur, sz;
-	while((sz = fread(buf, 1, sizeof(buf), f))) {
-		bufp = buf;
-		for(cur = 0; cur < sz && linep <= linee; cur++, bufp++) {
-			if(stripws && (*bufp == ' ' || *bufp == '\t')) {
-				continue;
+	for(char const* end = p + len; p != end; p++) {
+		if(stripws && (*p == ' ' || *p == '\t')) {
+			continue;
+		}
+		if(*p == '\n' || *p == '\r') {
+			*linep = '\0';
+			parseIniLine(line);
+			linep = line;
+			stripws = true;
+		} else {
+			stripws = false;
+			*linep = *p;
+			linep++;
+			if(linep > linee) {
+				throw EXCEPTION("Line too long");
 			}
-			if(*bufp == '\n' || *bufp == '\r') {
-				*linep = '\0';
-				parseIniLine(line);
-				linep = line;
-				stripws = true;
+		}
+	}
+	if(linep != line) {
+		*linep = '\0';
+		parseIniLine(line);
+	}
+}
+
+/* Records where each section's body starts and ends.  Anything before the
+ * first section is parsed straight away so errors there still show up at
+ * read time
+ */
+void INIFile::scanSections() {
+	char const* start = text.data();
+	char const* end = start + text.length();
+	Ranges* current = NULL;
+	size_t bodyStart = 0;
+	bool first = true;
+	for(char const* p = start; p != end; ) {
+		char const* lineEnd = p;
+		while(lineEnd != end && *lineEnd != '\n' && *lineEnd != '\r') {
+			lineEnd++;
+		}
+		char const* c = p;
+		while(c != lineEnd && (*c == ' ' || *c == '\t')) {
+			c++;
+		}
+		char const* close;
+		if(c != lineEnd && *c == '[' && (close = static_cast<char const*>(memchr(c + 1, ']', lineEnd - c - 1))) != NULL) {
+			if(first) {
+				parseText(start, p - start);
+				first = false;
 			} else {
-				stripws = false;
-				*linep = *bufp;
-				linep++;
+				current->push_back(std::make_pair(bodyStart, p - start));
 			}
+			current = &pending[std::string(c + 1, close - c - 1)];
+			bodyStart = lineEnd - start;
 		}
-		if(linep > linee) {
-			throw EXCEPTION("Line too long");
+		p = lineEnd == end ? end : lineEnd + 1;
+	}
+	if(first) {
+		parseText(start, text.length());
+		std::string().swap(text);
+	} else {
+		current->push_back(std::make_pair(bodyStart, text.length()));
+	}
+}
+
+void INIFile::loadSection(PendingMap::iterator it) const {
+	INIFile* self = const_cast<INIFile*>(this);
+	SectionMap::iterator saved = self->currentSection;
+	self->currentSection = sections.insert(std::make_pair(it->first, Section())).first;
+	try {
+		for(Ranges::const_iterator r = it->second.begin(); r != it->second.end(); r++) {
+			self->parseText(text.data() + r->first, r->second - r->first);
 		}
+	} catch(...) {
+		self->currentSection = saved;
+		throw;
+	}
+	self->currentSection = saved;
+	pending.erase(it);
+}
+
+/* The values of the numbered keys "1", "2", ... of a section, up to the
+ * first one missing, as (start, length) pieces: what Base64::decode would
+ * join together.  A section a lazy read hasn't parsed yet is scanned with
+ * the same rules as parseText, without parsing it, so the pieces are the
+ * same either way.  Returns false if the section doesn't exist.  The
+ * pointers are valid until the section is changed or the next read
+ */
+bool INIFile::getNumberedValues(std::string const& section, std::vector<std::pair<char const*, size_t> >& pieces) const {
+	pieces.clear();
+	char keyBuf[16];
+	PendingMap::const_iterator it = pending.find(section);
+	if(it == pending.end()) {
+		SectionMap::const_iterator sec = sections.find(section);
+		if(sec == sections.end()) {
+			return false;
+		}
+		for(unsigned int i = 1; ; i++) {
+			Section::const_iterator val = sec->second.find(std::string(keyBuf, snprintf(keyBuf, sizeof(keyBuf), "%u", i)));
+			if(val == sec->second.end()) {
+				break;
+			}
+			pieces.push_back(std::make_pair(val->second.str.data(), val->second.str.length()));
+		}
+		return true;
+	}
+
+	/* Keys are almost always in order and go straight into pieces, the odd
+	 * one from further on waits in later.  As with parseIniLine the first
+	 * of any duplicate keys wins
+	 */
+	std::map<unsigned long, std::pair<char const*, size_t> > later;
+	for(Ranges::const_iterator r = it->second.begin(); r != it->second.end(); r++) {
+		char const* p = text.data() + r->first;
+		char const* end = text.data() + r->second;
+		while(p != end) {
+			while(p != end && (*p == ' ' || *p == '\t')) {
+				p++;
+			}
+			char const* lineEnd = static_cast<char const*>(memchr(p, '\n', end - p));
+			if(lineEnd == NULL) {
+				lineEnd = end;
+			}
+			char const* cr = static_cast<char const*>(memchr(p, '\r', lineEnd - p));
+			if(cr != NULL) {
+				lineEnd = cr;
+			}
+			char const* eq;
+			if(p != lineEnd && *p >= '1' && *p <= '9' && (eq = static_cast<char const*>(memchr(p, '=', lineEnd - p))) != NULL) {
+				char const* keyEnd = eq;
+				while(keyEnd[-1] == ' ') {
+					keyEnd--;
+				}
+				char* numEnd;
+				unsigned long num = strtoul(p, &numEnd, 10);
+				if(numEnd == keyEnd && num > pieces.size()) {
+					char const* val = eq + 1;
+					char const* valEnd = lineEnd;
+					while(val != valEnd && (*val == ' ' || *val == '\t')) {
+						val++;
+					}
+					while(valEnd != val && (valEnd[-1] == ' ' || valEnd[-1] == '\t')) {
+						valEnd--;
+					}
+					std::pair<char const*, size_t> piece(val, valEnd - val);
+					if(num != pieces.size() + 1) {
+						later.insert(std::make_pair(num, piece));
+					} else if(later.empty() || later.find(num) == later.end()) {
+						pieces.push_back(piece);
+					}
+				}
+			}
+			while(!later.empty() && later.begin()->first <= pieces.size() + 1) {
+				if(later.begin()->first == pieces.size() + 1) {
+					pieces.push_back(later.begin()->second);
+				}
+				later.erase(later.begin());
+			}
+			p = lineEnd == end ? end : lineEnd + 1;
+		}
+	}
+	return true;
+}
+
+void INIFile::loadAll() const {
+	while(!pending.empty()) {
+		loadSection(pending.begin());
 	}
 }
 
@@ -194,6 +628,7 @@ bool INIFile::trim(std::string& str, std::string const& trimchars) {
 }
 
 INIFile::section_iterator INIFile::sectionsBegin() {
+	loadAll();
 	return sections.begin();
 }
 
@@ -0,0 +1,222 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "INIOverlay.h"
+
+uint32_t const INIOverlay::emptySlot = 0xFFFFFFFF;
+
+INIOverlay::INIOverlay() : table(64, emptySlot), haveSection(false) {
+}
+
+/* FNV-1a over the section name, a separator and the key */
+uint32_t INIOverlay::hash(std::string const& section, std::string const& key) {
+	uint32_t h = 2166136261u;
+	for(size_t i = 0; i != section.length(); i++) {
+		h ^= static_cast<uint8_t>(section[i]);
+		h *= 16777619u;
+	}
+	h *= 16777619u;
+	for(size_t i = 0; i != key.length(); i++) {
+		h ^= static_cast<uint8_t>(key[i]);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+uint32_t INIOverlay::lookup(std::string const& section, std::string const& key, uint32_t h) const {
+	uint32_t mask = table.size() - 1;
+	for(uint32_t i = h & mask; table[i] != emptySlot; i = (i + 1) & mask) {
+		Entry const& e = entries[table[i]];
+		if(e.hash == h && e.key == key && e.section == section) {
+			return table[i];
+		}
+	}
+	return emptySlot;
+}
+
+void INIOverlay::grow() {
+	table.assign(table.size() * 2, emptySlot);
+	uint32_t mask = table.size() - 1;
+	for(uint32_t e = 0; e != entries.size(); e++) {
+		uint32_t i = entries[e].hash & mask;
+		while(table[i] != emptySlot) {
+			i = (i + 1) & mask;
+		}
+		table[i] = e;
+	}
+}
+
+uint32_t INIOverlay::insert(std::string const& section, std::string const& key) {
+	uint32_t h = hash(section, key);
+	uint32_t found = lookup(section, key, h);
+	if(found != emptySlot) {
+		return found;
+	}
+	Entry e;
+	e.section = section;
+	e.key = key;
+	e.hash = h;
+	e.values.resize(layers.size(), NULL);
+	e.value = NULL;
+	entries.push_back(e);
+	uint32_t idx = entries.size() - 1;
+	if(entries.size() * 2 > table.size()) {
+		grow();
+	} else {
+		uint32_t mask = table.size() - 1;
+		uint32_t i = h & mask;
+		while(table[i] != emptySlot) {
+			i = (i + 1) & mask;
+		}
+		table[i] = idx;
+	}
+	return idx;
+}
+
+void INIOverlay::resolve(Entry& e) {
+	e.value = NULL;
+	for(size_t i = e.values.size(); i != 0; i--) {
+		if(e.values[i - 1] != NULL) {
+			e.value = e.values[i - 1];
+			return;
+		}
+	}
+}
+
+/* Forgets everything the layer contributed, the entries it had are left
+ * with the value from the next layer down (if any)
+ */
+void INIOverlay::unindexLayer(size_t l) {
+	Layer& layer = layers[l];
+	for(size_t i = 0; i != layer.entries.size(); i++) {
+		Entry& e = entries[layer.entries[i]];
+		e.values[l] = NULL;
+		resolve(e);
+	}
+	layer.entries.clear();
+	for(size_t i = 0; i != layer.sections.size(); i++) {
+		std::map<std::string, unsigned int>::iterator it = sectionLayers.find(layer.sections[i]);
+		if(--it->second == 0) {
+			sectionLayers.erase(it);
+		}
+	}
+	layer.sections.clear();
+}
+
+void INIOverlay::indexLayer(size_t l) {
+	INIFile& ini = *layers[l].ini;
+	for(INIFile::section_iterator it = ini.sectionsBegin(); it != ini.sectionsEnd(); it++) {
+		layers[l].sections.push_back(it->first);
+		sectionLayers[it->first]++;
+		for(INIFile::key_iterator jt = it->second.begin(); jt != it->second.end(); jt++) {
+			uint32_t idx = insert(it->first, jt->first);
+			Entry& e = entries[idx];
+			e.values[l] = &jt->second.str;
+			resolve(e);
+			layers[l].entries.push_back(idx);
+		}
+	}
+}
+
+/* Layers added later override earlier ones, returns the new layer's index */
+size_t INIOverlay::addLayer(INIFile& ini) {
+	Layer layer;
+	layer.ini = &ini;
+	layers.push_back(layer);
+	for(size_t i = 0; i != entries.size(); i++) {
+		entries[i].values.push_back(NULL);
+	}
+	indexLayer(layers.size() - 1);
+	return layers.size() - 1;
+}
+
+size_t INIOverlay::numLayers() const {
+	return layers.size();
+}
+
+/* Only the keys the layer had before or has now are looked at again */
+void INIOverlay::layerChanged(size_t l) {
+	if(l >= layers.size()) {
+		throw EXCEPTION("No layer %lu (have %lu)", l, layers.size());
+	}
+	unindexLayer(l);
+	indexLayer(l);
+}
+
+bool INIOverlay::sectionExists(std::string const& section) const {
+	return sectionLayers.find(section) != sectionLayers.end();
+}
+
+void INIOverlay::setCurrentSection(std::string const& section) {
+	currentSection = section;
+	haveSection = true;
+}
+
+std::string INIOverlay::getCurrentSectionName() const {
+	if(!haveSection) {
+		throw EXCEPTION("No current section");
+	}
+	return currentSection;
+}
+
+std::string const* INIOverlay::findKey(std::string const& section, std::string const& key) const {
+	uint32_t idx = lookup(section, key, hash(section, key));
+	if(idx == emptySlot) {
+		return NULL;
+	}
+	return entries[idx].value;
+}
+
+std::string const* INIOverlay::findKey(std::string const& key) const {
+	if(!haveSection) {
+		throw EXCEPTION("No current section");
+	}
+	return findKey(currentSection, key);
+}
+
+bool INIOverlay::keyExists(std::string const& key) const {
+	return findKey(key) != NULL;
+}
+
+std::string INIOverlay::getKey(std::string const& key) const {
+	std::string const* val = findKey(key);
+	if(val == NULL) {
+		throw EXCEPTION("Key not found");
+	}
+	return *val;
+}
+
+/* Index of the layer the key's value comes from, or -1 if no layer has it */
+int INIOverlay::getKeyLayer(std::string const& key) const {
+	if(!haveSection) {
+		throw EXCEPTION("No current section");
+	}
+	uint32_t idx = lookup(currentSection, key, hash(currentSection, key));
+	if(idx == emptySlot) {
+		return -1;
+	}
+	Entry const& e = entries[idx];
+	for(size_t i = e.values.size(); i != 0; i--) {
+		if(e.values[i - 1] != NULL) {
+			return i - 1;
+		}
+	}
+	return -1;
+}
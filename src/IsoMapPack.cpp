@@ -0,0 +1,194 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "IsoMapPack.h"
+#include "Exception.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#	include <emmintrin.h>
+#endif
+
+uint32_t const IsoMapPack::noCell = 0xFFFFFFFF;
+size_t const IsoMapPack::cellSize = 11;
+
+namespace {
+	int16_t load16(uint8_t const* p) {
+		int16_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+}
+
+IsoMapPack::IsoMapPack(uint8_t const* data, size_t len) : minX(0), minY(0), width(0), height(0) {
+	if(len % cellSize != 0) {
+		EWARN("IsoMapPack5 data is not a multiple of %lu bytes long (%lu bytes)", cellSize, len);
+	}
+	size_t n = len / cellSize;
+	x.resize(n);
+	y.resize(n);
+	tile.resize(n);
+	subTile.resize(n);
+	z.resize(n);
+	uint8_t const* cur = data;
+	for(size_t i = 0; i != n; i++, cur += cellSize) {
+		x[i] = load16(cur);
+		y[i] = load16(cur + 2);
+		tile[i] = load16(cur + 4);
+		subTile[i] = cur[8];
+		z[i] = cur[9];
+	}
+	buildGrid();
+}
+
+/* Where two cells share a position the later one wins */
+void IsoMapPack::buildGrid() {
+	if(x.empty()) {
+		return;
+	}
+	int32_t maxX = x[0], maxY = y[0];
+	minX = x[0];
+	minY = y[0];
+	for(size_t i = 1; i != x.size(); i++) {
+		if(x[i] < minX) minX = x[i];
+		if(x[i] > maxX) maxX = x[i];
+		if(y[i] < minY) minY = y[i];
+		if(y[i] > maxY) maxY = y[i];
+	}
+	width = maxX - minX + 1;
+	height = maxY - minY + 1;
+	grid.assign(static_cast<size_t>(width) * height, noCell);
+	for(size_t i = 0; i != x.size(); i++) {
+		grid[static_cast<size_t>(y[i] - minY) * width + (x[i] - minX)] = i;
+	}
+}
+
+uint32_t IsoMapPack::numCells() const {
+	return x.size();
+}
+
+int16_t const* IsoMapPack::getX() const {
+	return x.empty() ? NULL : &x[0];
+}
+
+int16_t const* IsoMapPack::getY() const {
+	return y.empty() ? NULL : &y[0];
+}
+
+int16_t const* IsoMapPack::getTile() const {
+	return tile.empty() ? NULL : &tile[0];
+}
+
+uint8_t const* IsoMapPack::getSubTile() const {
+	return subTile.empty() ? NULL : &subTile[0];
+}
+
+int8_t const* IsoMapPack::getZ() const {
+	return z.empty() ? NULL : &z[0];
+}
+
+/* The area covered by the grid, positions outside it have no cells */
+void IsoMapPack::getBounds(int32_t& bx, int32_t& by, uint32_t& w, uint32_t& h) const {
+	bx = minX;
+	by = minY;
+	w = width;
+	h = height;
+}
+
+uint32_t IsoMapPack::findCell(int32_t cx, int32_t cy) const {
+	if(cx < minX || cy < minY || cx - minX >= static_cast<int32_t>(width) || cy - minY >= static_cast<int32_t>(height)) {
+		return noCell;
+	}
+	return grid[static_cast<size_t>(cy - minY) * width + (cx - minX)];
+}
+
+/* Cell indices for x = minX .. minX + width - 1 (noCell where there is
+ * none), or NULL if y is outside the grid
+ */
+uint32_t const* IsoMapPack::getRow(int32_t cy) const {
+	if(cy < minY || cy - minY >= static_cast<int32_t>(height)) {
+		return NULL;
+	}
+	return &grid[static_cast<size_t>(cy - minY) * width];
+}
+
+/* Appends the index of every cell with first <= tile <= last to cells,
+ * returning how many were found.  Tiles are compared as stored, so -1
+ * (which the renderer treats as tile 0) only matches a range including -1
+ */
+size_t IsoMapPack::findTiles(int16_t first, int16_t last, std::vector<uint32_t>& cells) const {
+	size_t found = 0;
+	size_t i = 0;
+	size_t n = tile.size();
+#ifdef __SSE2__
+	/* Signed compares: in range is !(t < first) && !(t > last) */
+	__m128i lo = _mm_set1_epi16(first);
+	__m128i hi = _mm_set1_epi16(last);
+	for(; i + 8 <= n; i += 8) {
+		__m128i t = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&tile[i]));
+		__m128i out = _mm_or_si128(_mm_cmplt_epi16(t, lo), _mm_cmpgt_epi16(t, hi));
+		unsigned int mask = ~_mm_movemask_epi8(out) & 0xFFFF;
+		while(mask != 0) {
+			unsigned int bit = __builtin_ctz(mask);
+			cells.push_back(i + bit / 2);
+			found++;
+			mask &= ~(3u << bit);
+		}
+	}
+#endif
+	for(; i != n; i++) {
+		if(tile[i] >= first && tile[i] <= last) {
+			cells.push_back(i);
+			found++;
+		}
+	}
+	return found;
+}
+
+size_t IsoMapPack::countTiles(int16_t first, int16_t last) const {
+	size_t found = 0;
+	size_t i = 0;
+	size_t n = tile.size();
+#ifdef __SSE2__
+	__m128i lo = _mm_set1_epi16(first);
+	__m128i hi = _mm_set1_epi16(last);
+	for(; i + 8 <= n; i += 8) {
+		__m128i t = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&tile[i]));
+		__m128i out = _mm_or_si128(_mm_cmplt_epi16(t, lo), _mm_cmpgt_epi16(t, hi));
+		found += __builtin_popcount(~_mm_movemask_epi8(out) & 0xFFFF) / 2;
+	}
+#endif
+	for(; i != n; i++) {
+		if(tile[i] >= first && tile[i] <= last) {
+			found++;
+		}
+	}
+	return found;
+}
+
+void IsoMapPack::print() const {
+	printf("There are %u cells in a %u x %u grid at (%i, %i)\n", numCells(), width, height, minX, minY);
+	for(uint32_t i = 0; i != numCells(); i++) {
+		printf("Cell %u - position (%i, %i, %i), tile %i / %i\n",
+			i, x[i], y[i], z[i], tile[i], subTile[i]
+		);
+	}
+}
@@ -0,0 +1,51 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "LZOCompress.h"
+#include "LZODecompress.h"
+#include "Exception.h"
+#include "Utils.h"
+
+extern "C" {
+#	include "minilzo.h"
+}
+
+/* Worst case expansion of incompressible data, from the LZO documentation */
+size_t LZOCompress::maxCompressedSize(size_t inlen) {
+	return inlen + inlen / 16 + 64 + 3;
+}
+
+/* Returns the compressed size, out must have room for
+ * maxCompressedSize(inlen) bytes.  The dictionary is allocated per call so
+ * this can be called from several threads at once
+ */
+size_t LZOCompress::compress(uint8_t const* in, uint8_t* out, size_t inlen, size_t outlen) {
+	LZODecompress::initLZO();
+	if(outlen < maxCompressedSize(inlen)) {
+		throw EXCEPTION("Output buffer of %lu bytes may be too small to compress %lu bytes", outlen, inlen);
+	}
+	Utils::ScopedArray<lzo_align_t> wrkmem(new lzo_align_t[(LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t)]);
+	lzo_uint len = outlen;
+	int r = lzo1x_1_compress(in, inlen, out, &len, wrkmem.ptr);
+	if(r != LZO_E_OK) {
+		throw EXCEPTION("LZO Error %i (%s) occured", r, r < 0 && r > -10 ? LZODecompress::errorText[-r] : "Unknown");
+	}
+	return len;
+}
@@ -19,6 +19,7 @@
 
 #include "LZODecompress.h"
 #include "Exception.h"
+#include <pthread.h>
 
 extern "C" {
 #	include "minilzo.h"
@@ -37,28 +38,235 @@ char const * LZODecompress::errorText[] = {
 	"LZO_E_NOT_YET_IMPLEMENTED",
 };
 
+namespace {
+	int initResult = LZO_E_ERROR;
+
+	void runInit() {
+		initResult = lzo_init();
+	}
+}
+
+/* Packs are decompressed from several threads at once, so lzo_init has to
+ * be run exactly once whoever gets here first
+ */
 void LZODecompress::initLZO() {
-	static bool initialised = false;
-	if(!initialised) {
-		if(lzo_init() != LZO_E_OK) {
-			throw EXCEPTION("Could not initialised LZO library");
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+	pthread_once(&once, &runInit);
+	if(initResult != LZO_E_OK) {
+		throw EXCEPTION("Could not initialised LZO library");
+	}
+}
+
+namespace {
+	void throwError(int r) {
+		if(r == LZO_E_OUTPUT_OVERRUN) {
+			throw EXCEPTION("Overran output buffer when LZO decompressing data");
+		}
+		throw EXCEPTION("LZO Error %i (%s) occured", r, r < 0 && r > -10 ? LZODecompress::errorText[-r] : "Unknown");
+	}
+
+	/* Copies n bytes 16 at a time, writing (and reading) up to 15 more */
+	inline void copyWide(uint8_t* op, uint8_t const* ip, size_t n) {
+		for(size_t i = 0; i < n; i += 16) {
+			memcpy(op + i, ip + i, 16);
+		}
+	}
+
+	/* Copies an n byte match from dist bytes back.  Chunks never read bytes
+	 * they haven't written yet as long as the chunk size is <= dist
+	 */
+	inline void copyMatch(uint8_t* op, size_t dist, size_t n, size_t room) {
+		uint8_t const* m = op - dist;
+		if(dist >= 16 && room >= n + 15) {
+			copyWide(op, m, n);
+		} else if(dist >= 8 && room >= n + 7) {
+			for(size_t i = 0; i < n; i += 8) {
+				memcpy(op + i, m + i, 8);
+			}
+		} else if(dist == 1) {
+			memset(op, *m, n);
+		} else {
+			for(size_t i = 0; i != n; i++) {
+				op[i] = m[i];
+			}
+		}
+	}
+
+	inline void copyLiterals(uint8_t* op, uint8_t const* ip, size_t n, size_t opRoom, size_t ipRoom) {
+		if(opRoom >= n + 15 && ipRoom >= n + 15) {
+			copyWide(op, ip, n);
+		} else {
+			memcpy(op, ip, n);
 		}
-		initialised = true;
 	}
 }
 
 size_t LZODecompress::decompress(uint8_t const* in, uint8_t* out, size_t inlen, size_t outlen) {
 	initLZO();
-	size_t len;
+	/* The safe decompressor takes the space available in len */
+	lzo_uint len = outlen;
 	int r = lzo1x_decompress_safe(in, inlen, out, &len, NULL);
 	if(r == LZO_E_INPUT_NOT_CONSUMED) {
 		DEBUG("Not all input data consumed when decompressing");
 	} else if(r != LZO_E_OK) {
-		if(r == LZO_E_OUTPUT_OVERRUN) {
-			throw EXCEPTION("Overran output buffer when LZO decompressing data");
-		} else {
-			throw EXCEPTION("LZO Error %i (%s) occured", r, r < 0 && r > -10 ? errorText[-r] : "Unknown");
-		}
+		throwError(r);
 	}
 	return len;
 }
+
+/* A reimplementation of lzo1x_decompress_safe with the same results (it
+ * fails wherever the minilzo version does, and returns the same data and
+ * length where that succeeds) but with the bounds checks done once per
+ * instruction and the copies done in 8 or 16 byte chunks wherever the
+ * buffers have room for the overrun.  Nothing is ever written past outlen,
+ * which matters as the sections of a pack are unpacked next to each other
+ * on different threads, but bytes between the returned length and outlen
+ * may be overwritten.  It also doesn't need lzo_init.
+ *
+ * The structure (and the gotos) follow lzo1x_d.ch so the two can be
+ * compared; lengths are in the same units as there, a match copies t + 2
+ * bytes
+ */
+size_t LZODecompress::decompressFast(uint8_t const* in, uint8_t* out, size_t inlen, size_t outlen) {
+	uint8_t const* ip = in;
+	uint8_t const* const ipEnd = in + inlen;
+	uint8_t* op = out;
+	uint8_t* const opEnd = out + outlen;
+	size_t t, dist;
+	int r = LZO_E_OK;
+
+#define FAST_NEED_IP(x) if(static_cast<size_t>(ipEnd - ip) < static_cast<size_t>(x)) { r = LZO_E_INPUT_OVERRUN; goto fail; }
+#define FAST_NEED_OP(x) if(static_cast<size_t>(opEnd - op) < static_cast<size_t>(x)) { r = LZO_E_OUTPUT_OVERRUN; goto fail; }
+#define FAST_TEST_LB(d) if((d) > static_cast<size_t>(op - out)) { r = LZO_E_LOOKBEHIND_OVERRUN; goto fail; }
+#define FAST_LONG_LENGTH(base) \
+	FAST_NEED_IP(1); \
+	while(*ip == 0) { \
+		t += 255; \
+		ip++; \
+		FAST_NEED_IP(1); \
+	} \
+	t += (base) + *ip++;
+
+	FAST_NEED_IP(1);
+	if(*ip > 17) {
+		t = *ip++ - 17;
+		if(t < 4) {
+			goto matchNext;
+		}
+		FAST_NEED_OP(t);
+		FAST_NEED_IP(t + 1);
+		copyLiterals(op, ip, t, opEnd - op, ipEnd - ip);
+		op += t;
+		ip += t;
+		goto firstLiteralRun;
+	}
+
+	while(ip < ipEnd) {
+		t = *ip++;
+		if(t >= 16) {
+			goto match;
+		}
+		if(t == 0) {
+			FAST_LONG_LENGTH(15);
+		}
+		FAST_NEED_OP(t + 3);
+		FAST_NEED_IP(t + 4);
+		copyLiterals(op, ip, t + 3, opEnd - op, ipEnd - ip);
+		op += t + 3;
+		ip += t + 3;
+
+firstLiteralRun:
+		t = *ip++;
+		if(t >= 16) {
+			goto match;
+		}
+		FAST_NEED_IP(1);
+		dist = (1 + 0x0800) + (t >> 2) + (*ip++ << 2);
+		FAST_TEST_LB(dist);
+		FAST_NEED_OP(3);
+		op[0] = *(op - dist);
+		op[1] = *(op + 1 - dist);
+		op[2] = *(op + 2 - dist);
+		op += 3;
+		goto matchDone;
+
+		do {
+match:
+			if(t >= 64) {
+				FAST_NEED_IP(1);
+				dist = 1 + ((t >> 2) & 7) + (*ip++ << 3);
+				t = (t >> 5) - 1;
+			} else if(t >= 32) {
+				t &= 31;
+				if(t == 0) {
+					FAST_LONG_LENGTH(31);
+				}
+				FAST_NEED_IP(2);
+				dist = 1 + (ip[0] >> 2) + (ip[1] << 6);
+				ip += 2;
+			} else if(t >= 16) {
+				dist = (t & 8) << 11;
+				t &= 7;
+				if(t == 0) {
+					FAST_LONG_LENGTH(7);
+				}
+				FAST_NEED_IP(2);
+				dist += (ip[0] >> 2) + (ip[1] << 6);
+				ip += 2;
+				if(dist == 0) {
+					goto eofFound;
+				}
+				dist += 0x4000;
+			} else {
+				FAST_NEED_IP(1);
+				dist = 1 + (t >> 2) + (*ip++ << 2);
+				FAST_TEST_LB(dist);
+				FAST_NEED_OP(2);
+				op[0] = *(op - dist);
+				op[1] = *(op + 1 - dist);
+				op += 2;
+				goto matchDone;
+			}
+			FAST_TEST_LB(dist);
+			FAST_NEED_OP(t + 2);
+			copyMatch(op, dist, t + 2, opEnd - op);
+			op += t + 2;
+
+matchDone:
+			t = ip[-2] & 3;
+			if(t == 0) {
+				break;
+			}
+
+matchNext:
+			FAST_NEED_OP(t);
+			FAST_NEED_IP(t + 1);
+			op[0] = ip[0];
+			if(t > 1) {
+				op[1] = ip[1];
+				if(t > 2) {
+					op[2] = ip[2];
+				}
+			}
+			op += t;
+			ip += t;
+			t = *ip++;
+		} while(ip < ipEnd);
+	}
+	r = LZO_E_EOF_NOT_FOUND;
+	goto fail;
+
+#undef FAST_NEED_IP
+#undef FAST_NEED_OP
+#undef FAST_TEST_LB
+#undef FAST_LONG_LENGTH
+
+eofFound:
+	if(ip < ipEnd) {
+		DEBUG("Not all input data consumed when decompressing");
+	}
+	return op - out;
+fail:
+	throwError(r);
+	return 0;
+}
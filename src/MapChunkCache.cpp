@@ -0,0 +1,146 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "MapChunkCache.h"
+#include "Exception.h"
+#include <algorithm>
+#include <string.h>
+#include <stdio.h>
+
+MapChunkCache::MapChunkCache(MapRenderer const& r, uint32_t size, size_t b) :
+		renderer(r), chunkSize(size), budget(b), hits(0), misses(0) {
+	if(chunkSize == 0) {
+		throw EXCEPTION("Chunk size must be non-zero");
+	}
+	uint32_t w, h;
+	renderer.getSize(w, h);
+	chunksX = (w + chunkSize - 1) / chunkSize;
+	chunksY = (h + chunkSize - 1) / chunkSize;
+	/* Bucket the cells by chunk row once, in painter order, so rendering a
+	 * chunk only has to look at the cells which can possibly touch it
+	 */
+	renderer.bucketRows(chunkSize, rowCells);
+	EDEBUG("Map split into %u x %u chunks of %u pixels", chunksX, chunksY, chunkSize);
+}
+
+MapChunkCache::~MapChunkCache() {
+	clear();
+}
+
+uint32_t MapChunkCache::getChunkSize() const {
+	return chunkSize;
+}
+
+void MapChunkCache::renderChunk(uint32_t cx, uint32_t cy, uint8_t* pixels) const {
+	int32_t x0 = cx * chunkSize, y0 = cy * chunkSize;
+	int32_t x1 = x0 + chunkSize, y1 = y0 + chunkSize;
+	memset(pixels, 0, chunkSize * chunkSize);
+	std::vector<uint32_t> const& list = rowCells[cy];
+	for(std::vector<uint32_t>::const_iterator it = list.begin(); it != list.end(); it++) {
+		MapRenderer::Cell const& cell = renderer.getCell(*it);
+		if(cell.right > x0 && cell.left < x1 && cell.bottom > y0 && cell.top < y1) {
+			renderer.drawCell(cell, pixels, chunkSize, x0, y0, x1, y1);
+		}
+	}
+}
+
+/* Drops least recently used chunks until there is room for sz more bytes */
+void MapChunkCache::evict(size_t sz) {
+	size_t chunkBytes = chunkSize * chunkSize;
+	while(!chunks.empty() && (chunks.size() * chunkBytes) + sz > budget) {
+		Chunk& c = chunks.back();
+		index.erase(c.key);
+		delete[] c.pixels;
+		chunks.pop_back();
+	}
+}
+
+/* Returns a chunkSize x chunkSize image, valid until the next call */
+uint8_t const* MapChunkCache::getChunk(uint32_t cx, uint32_t cy) {
+	if(cx >= chunksX || cy >= chunksY) {
+		throw EXCEPTION("Chunk (%u, %u) is out of range [%u %u]", cx, cy, chunksX, chunksY);
+	}
+	uint32_t key = cy * chunksX + cx;
+	ChunkMap::iterator it = index.find(key);
+	if(it != index.end()) {
+		hits++;
+		chunks.splice(chunks.begin(), chunks, it->second);
+		return chunks.front().pixels;
+	}
+	misses++;
+	evict(chunkSize * chunkSize);
+	Chunk c;
+	c.key = key;
+	c.pixels = new uint8_t[chunkSize * chunkSize];
+	renderChunk(cx, cy, c.pixels);
+	chunks.push_front(c);
+	index[key] = chunks.begin();
+	return c.pixels;
+}
+
+/* Fills a w x h image with the part of the map at (x, y), anything outside
+ * the map is colour 0
+ */
+void MapChunkCache::renderViewport(uint8_t* img, size_t scanWidth, int32_t x, int32_t y, uint32_t w, uint32_t h) {
+	for(uint32_t row = 0; row != h; row++) {
+		memset(&img[row * scanWidth], 0, w);
+	}
+	int32_t mapW = chunksX * chunkSize, mapH = chunksY * chunkSize;
+	int32_t x0 = std::max(x, 0), y0 = std::max(y, 0);
+	int32_t x1 = std::min(x + static_cast<int32_t>(w), mapW);
+	int32_t y1 = std::min(y + static_cast<int32_t>(h), mapH);
+	if(x0 >= x1 || y0 >= y1) {
+		return;
+	}
+	for(uint32_t cy = y0 / chunkSize; cy <= (y1 - 1) / chunkSize; cy++) {
+		for(uint32_t cx = x0 / chunkSize; cx <= (x1 - 1) / chunkSize; cx++) {
+			uint8_t const* chunk = getChunk(cx, cy);
+			int32_t cx0 = std::max<int32_t>(x0, cx * chunkSize);
+			int32_t cx1 = std::min<int32_t>(x1, (cx + 1) * chunkSize);
+			int32_t cy0 = std::max<int32_t>(y0, cy * chunkSize);
+			int32_t cy1 = std::min<int32_t>(y1, (cy + 1) * chunkSize);
+			for(int32_t py = cy0; py < cy1; py++) {
+				memcpy(&img[(py - y) * scanWidth + (cx0 - x)],
+					&chunk[(py - cy * chunkSize) * chunkSize + (cx0 - cx * chunkSize)],
+					cx1 - cx0);
+			}
+		}
+	}
+}
+
+void MapChunkCache::setBudget(size_t b) {
+	budget = b;
+	evict(0);
+}
+
+void MapChunkCache::clear() {
+	for(ChunkList::iterator it = chunks.begin(); it != chunks.end(); it++) {
+		delete[] it->pixels;
+	}
+	chunks.clear();
+	index.clear();
+}
+
+void MapChunkCache::print() {
+	printf("%u x %u chunks of %u pixels, %lu cached (%lu of %lu bytes), %u hits, %u misses\n",
+		chunksX, chunksY, chunkSize, chunks.size(),
+		chunks.size() * chunkSize * chunkSize, budget, hits, misses
+	);
+}
@@ -0,0 +1,249 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "MapIndex.h"
+#include "INIFile.h"
+#include "MapPreview.h"
+#include "Exception.h"
+#include "Utils.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+uint32_t const MapIndex::version = 1;
+
+namespace {
+	char const magic[4] = { 'R', 'A', '2', 'I' };
+
+	/* The tools already assume a little endian host when reading the game
+	 * files, the index is stored the same way
+	 */
+	template<typename T>
+	void put(Utils::BufferedWrite& out, T v) {
+		out.write(&v, sizeof(v));
+	}
+
+	void putString(Utils::BufferedWrite& out, std::string const& str) {
+		if(str.length() > 0xFFFF) {
+			throw EXCEPTION("String of %lu characters is too long for the index", str.length());
+		}
+		put<uint16_t>(out, str.length());
+		out.write(str);
+	}
+
+	void putImage(Utils::BufferedWrite& out, MapIndex::Image const& img) {
+		put(out, img.width);
+		put(out, img.height);
+		if(!img.rgb.empty()) {
+			out.write(&img.rgb[0], img.rgb.size());
+		}
+	}
+
+	template<typename T>
+	T get(Utils::FixedRead& in) {
+		T v;
+		in.read(&v);
+		return v;
+	}
+
+	std::string getString(Utils::FixedRead& in) {
+		uint16_t len = get<uint16_t>(in);
+		std::string str(len, '\0');
+		if(len != 0) {
+			in.read(&str[0], len);
+		}
+		return str;
+	}
+
+	void getImage(Utils::FixedRead& in, MapIndex::Image& img) {
+		img.width = get<uint16_t>(in);
+		img.height = get<uint16_t>(in);
+		img.rgb.resize(static_cast<size_t>(img.width) * img.height * 3);
+		if(!img.rgb.empty()) {
+			in.read(&img.rgb[0], img.rgb.size());
+		}
+	}
+}
+
+void MapIndex::Image::fromRGBA(uint8_t const* rgba, uint16_t w, uint16_t h) {
+	width = w;
+	height = h;
+	size_t pixels = static_cast<size_t>(w) * h;
+	rgb.resize(pixels * 3);
+	for(size_t i = 0; i != pixels; i++) {
+		rgb[i * 3] = rgba[i * 4];
+		rgb[i * 3 + 1] = rgba[i * 4 + 1];
+		rgb[i * 3 + 2] = rgba[i * 4 + 2];
+	}
+}
+
+MapIndex::Entry::Entry() : fileSize(0), modified(0), hash(0), players(0) {
+	memset(size, 0, sizeof(size));
+	memset(localSize, 0, sizeof(localSize));
+}
+
+/* Fills in everything that comes from the map itself, missing keys just
+ * leave the defaults.  The radar image needs the theater so is left to the
+ * caller.
+ */
+void MapIndex::Entry::readMetadata(INIFile& map) {
+	if(map.sectionExists("Basic")) {
+		map.setCurrentSection("Basic");
+		std::string const* str = map.findKey("Name");
+		if(str != NULL) {
+			name = *str;
+		}
+	}
+	if(map.sectionExists("Map")) {
+		map.setCurrentSection("Map");
+		std::string const* str = map.findKey("Theater");
+		if(str != NULL) {
+			theater = *str;
+		}
+		std::vector<int> rect;
+		if(map.getIntList("Size", rect) && rect.size() == 4) {
+			std::copy(rect.begin(), rect.end(), size);
+		}
+		if(map.getIntList("LocalSize", rect) && rect.size() == 4) {
+			std::copy(rect.begin(), rect.end(), localSize);
+		}
+	}
+	/* Multiplayer start positions are waypoints 0-7 */
+	players = 0;
+	if(map.sectionExists("Waypoints")) {
+		map.setCurrentSection("Waypoints");
+		for(char wp = '0'; wp != '8'; wp++) {
+			if(map.keyExists(std::string(1, wp))) {
+				players++;
+			}
+		}
+	}
+	uint32_t w, h;
+	if(MapPreview::getSize(map, w, h)) {
+		if(w > 0xFFFF || h > 0xFFFF) {
+			throw EXCEPTION("Preview of %u x %u is too large", w, h);
+		}
+		Utils::ScopedArray<uint8_t> rgba(new uint8_t[static_cast<size_t>(w) * h * 4]);
+		MapPreview::decode(map, rgba.ptr, w, h);
+		preview.fromRGBA(rgba.ptr, w, h);
+	}
+}
+
+/* 64 bit FNV-1a */
+uint64_t MapIndex::hash(uint8_t const* data, size_t len) {
+	return Utils::fnv1a64(data, len);
+}
+
+void MapIndex::read(std::string const& fn) {
+	FILE* f = fopen(fn.c_str(), "rb");
+	if(f == NULL) {
+		throw EXCEPTION("Could not open \"%s\" (%s)", fn.c_str(), strerror(errno));
+	}
+	Utils::FixedRead in(f);
+	char m[4];
+	in.read(m, 4);
+	if(memcmp(m, magic, sizeof(magic)) != 0) {
+		throw EXCEPTION("\"%s\" is not a map index", fn.c_str());
+	}
+	uint32_t v = get<uint32_t>(in);
+	if(v != version) {
+		throw EXCEPTION("\"%s\" is index version %u, expected %u", fn.c_str(), v, version);
+	}
+	uint32_t count = get<uint32_t>(in);
+	EntryMap loaded;
+	for(uint32_t i = 0; i != count; i++) {
+		Entry e;
+		e.path = getString(in);
+		e.fileSize = get<uint64_t>(in);
+		e.modified = get<int64_t>(in);
+		e.hash = get<uint64_t>(in);
+		e.name = getString(in);
+		e.theater = getString(in);
+		in.read(e.size, 4);
+		in.read(e.localSize, 4);
+		e.players = get<uint8_t>(in);
+		getImage(in, e.preview);
+		getImage(in, e.radar);
+		loaded[e.path] = e;
+	}
+	entries.swap(loaded);
+}
+
+/* Written to a temporary file first so a failed run leaves the old index */
+void MapIndex::write(std::string const& fn) const {
+	std::string tmp = fn + ".tmp";
+	FILE* f = fopen(tmp.c_str(), "wb");
+	if(f == NULL) {
+		throw EXCEPTION("Could not open \"%s\" for writing (%s)", tmp.c_str(), strerror(errno));
+	}
+	{
+		Utils::ScopedFile f_close(f);
+		Utils::BufferedWrite out(f);
+		out.write(magic, sizeof(magic));
+		put<uint32_t>(out, version);
+		put<uint32_t>(out, entries.size());
+		for(EntryMap::const_iterator it = entries.begin(); it != entries.end(); it++) {
+			Entry const& e = it->second;
+			putString(out, e.path);
+			put(out, e.fileSize);
+			put(out, e.modified);
+			put(out, e.hash);
+			putString(out, e.name);
+			putString(out, e.theater);
+			out.write(e.size, sizeof(e.size));
+			out.write(e.localSize, sizeof(e.localSize));
+			put(out, e.players);
+			putImage(out, e.preview);
+			putImage(out, e.radar);
+		}
+		out.flush();
+		if(fflush(f) != 0) {
+			throw EXCEPTION("Could not write \"%s\" (%s)", tmp.c_str(), strerror(errno));
+		}
+	}
+	if(rename(tmp.c_str(), fn.c_str()) != 0) {
+		throw EXCEPTION("Could not rename \"%s\" to \"%s\" (%s)", tmp.c_str(), fn.c_str(), strerror(errno));
+	}
+}
+
+size_t MapIndex::numEntries() const {
+	return entries.size();
+}
+
+MapIndex::Entry const* MapIndex::find(std::string const& path) const {
+	EntryMap::const_iterator it = entries.find(path);
+	return it == entries.end() ? NULL : &it->second;
+}
+
+void MapIndex::set(Entry const& e) {
+	entries[e.path] = e;
+}
+
+/* Drops the entries for maps which are no longer in the catalogue */
+void MapIndex::retain(std::vector<std::string> const& paths) {
+	EntryMap kept;
+	for(size_t i = 0; i != paths.size(); i++) {
+		EntryMap::iterator it = entries.find(paths[i]);
+		if(it != entries.end()) {
+			kept.insert(*it);
+		}
+	}
+	entries.swap(kept);
+}
@@ -0,0 +1,93 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "MapList.h"
+#include "Exception.h"
+#include <dirent.h>
+#include <errno.h>
+#include <exception>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+
+uint8_t const MapList::Failed = 0;
+
+bool MapList::isMapFile(std::string const& name) {
+	char const* ext[] = { ".map", ".mpr", ".yrm" };
+	for(unsigned int i = 0; i != sizeof(ext) / sizeof(ext[0]); i++) {
+		size_t len = strlen(ext[i]);
+		if(name.length() > len && strcasecmp(name.c_str() + name.length() - len, ext[i]) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* A directory adds the map files directly inside it, anything else is taken
+ * to be a map whatever it's called
+ */
+void MapList::add(std::string const& path) {
+	struct stat st;
+	if(stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+		DIR* dir = opendir(path.c_str());
+		if(dir == NULL) {
+			throw EXCEPTION("Could not open directory \"%s\" (%s)", path.c_str(), strerror(errno));
+		}
+		struct dirent* ent;
+		while((ent = readdir(dir)) != NULL) {
+			if(isMapFile(ent->d_name)) {
+				maps.push_back(path + "/" + ent->d_name);
+			}
+		}
+		closedir(dir);
+	} else {
+		maps.push_back(path);
+	}
+}
+
+void MapList::add(char** paths, int n) {
+	for(int i = 0; i < n; i++) {
+		add(paths[i]);
+	}
+}
+
+size_t MapList::count(uint8_t s) const {
+	size_t n = 0;
+	for(size_t i = 0; i != status.size(); i++) {
+		n += status[i] == s;
+	}
+	return n;
+}
+
+void MapList::run(size_t n) {
+	try {
+		status[n] = process(n, maps[n]);
+	} catch(Exception& e) {
+		fprintf(stderr, "%s: %s\n", maps[n].c_str(), e.what());
+	} catch(std::exception& e) {
+		fprintf(stderr, "%s: %s\n", maps[n].c_str(), e.what());
+	}
+}
+
+void MapList::runAll() {
+	status.assign(maps.size(), Failed);
+	WorkQueue::run(*this, maps.size());
+}
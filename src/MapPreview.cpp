@@ -0,0 +1,127 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "MapPreview.h"
+#include "Base64.h"
+#include "INIFile.h"
+#include "MapReader.h"
+#include "Exception.h"
+#include "Utils.h"
+#include <pthread.h>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#	define MAPPREVIEW_X86
+#	include <immintrin.h>
+#endif
+
+namespace {
+	void rgbToRGBAScalar(uint8_t const* rgb, uint8_t* rgba, size_t pixels) {
+		for(size_t i = 0; i != pixels; i++) {
+			rgba[0] = rgb[0];
+			rgba[1] = rgb[1];
+			rgba[2] = rgb[2];
+			rgba[3] = 0xFF;
+			rgb += 3;
+			rgba += 4;
+		}
+	}
+
+#ifdef MAPPREVIEW_X86
+	/* 16 pixels per pass: the three input registers are realigned so each
+	 * holds the next 4 pixels in its low 12 bytes, then one shuffle spreads
+	 * them out and the alpha is or-ed in
+	 */
+	__attribute__((target("ssse3")))
+	void rgbToRGBASSSE3(uint8_t const* rgb, uint8_t* rgba, size_t pixels) {
+		__m128i const spread = _mm_setr_epi8(
+			0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		__m128i const alpha = _mm_set1_epi32(0xFF000000);
+		size_t i = 0;
+		for(; pixels - i >= 16; i += 16) {
+			__m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(rgb));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(rgb + 16));
+			__m128i c = _mm_loadu_si128(reinterpret_cast<__m128i const*>(rgb + 32));
+			__m128i p0 = a;
+			__m128i p1 = _mm_alignr_epi8(b, a, 12);
+			__m128i p2 = _mm_alignr_epi8(c, b, 8);
+			__m128i p3 = _mm_srli_si128(c, 4);
+			__m128i* out = reinterpret_cast<__m128i*>(rgba);
+			_mm_storeu_si128(out, _mm_or_si128(_mm_shuffle_epi8(p0, spread), alpha));
+			_mm_storeu_si128(out + 1, _mm_or_si128(_mm_shuffle_epi8(p1, spread), alpha));
+			_mm_storeu_si128(out + 2, _mm_or_si128(_mm_shuffle_epi8(p2, spread), alpha));
+			_mm_storeu_si128(out + 3, _mm_or_si128(_mm_shuffle_epi8(p3, spread), alpha));
+			rgb += 48;
+			rgba += 64;
+		}
+		rgbToRGBAScalar(rgb, rgba, pixels - i);
+	}
+#endif
+
+}
+
+MapPreview::Converter MapPreview::converter = &rgbToRGBAScalar;
+
+void MapPreview::initialiseConverter() {
+#ifdef MAPPREVIEW_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("ssse3")) {
+		converter = &rgbToRGBASSSE3;
+	}
+#endif
+}
+
+void MapPreview::initialise() {
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+	pthread_once(&once, &initialiseConverter);
+}
+
+/* Returns false if the map has no usable preview */
+bool MapPreview::getSize(INIFile& map, uint32_t& w, uint32_t& h) {
+	if(!map.sectionExists("Preview") || !map.sectionExists("PreviewPack")) {
+		return false;
+	}
+	map.setCurrentSection("Preview");
+	std::vector<int> size;
+	if(!map.getIntList("Size", size) || size.size() != 4 || size[2] <= 0 || size[3] <= 0) {
+		return false;
+	}
+	w = size[2];
+	h = size[3];
+	return true;
+}
+
+void MapPreview::rgbToRGBA(uint8_t const* rgb, uint8_t* rgba, size_t pixels) {
+	initialise();
+	converter(rgb, rgba, pixels);
+}
+
+/* Fills rgba, which must hold w * h pixels, from the map's PreviewPack */
+void MapPreview::decode(INIFile& map, uint8_t* rgba, uint32_t w, uint32_t h, unsigned int threads) {
+	size_t len, unpackedLen;
+	map.setCurrentSection("PreviewPack");
+	Utils::ScopedArray<uint8_t> data(Base64::decode(map, len));
+	Utils::ScopedArray<uint8_t> rgb(MapReader::unpack(data.ptr, len, unpackedLen, MapReader::LZOPack, threads));
+	size_t pixels = static_cast<size_t>(w) * h;
+	if(unpackedLen != pixels * 3) {
+		throw EXCEPTION("PreviewPack unpacked to %lu bytes, a %u x %u preview needs %lu", unpackedLen, w, h, pixels * 3);
+	}
+	rgbToRGBA(rgb.ptr, rgba, pixels);
+}
@@ -19,72 +19,91 @@
 
 #include "MapReader.h"
 #include "LZODecompress.h"
+#include "LZOCompress.h"
+#include "WorkQueue.h"
 #include <vector>
 #include <stdio.h>
 
 int const MapReader::LZOPack = 1;
 int const MapReader::F80Pack = 2;
+unsigned int const MapReader::decode4TableSize = 128;
 
 /* This code is a reimplementation of the algorithm written by
  * Olaf van der Spek in the XCC code (map_ts_encoder.cpp, function
  * preview_decode4)
  */
 size_t MapReader::decode4(uint16_t* buf, size_t bufLen, uint8_t* out, size_t outLen, Palette& pal) {
-	std::vector<uint64_t> colLookup;
-	uint64_t cp = 0;
-	uint8_t rgb[3];
-	for(unsigned int i = 0; i != 256; i++) {
-		pal.getRGB(i, rgb[0], rgb[1], rgb[2]);
-		for(unsigned int j = 0; j != 3; j++) {
-			cp |= rgb[j];
-			cp <<= 8;
-		}
-		if(i % 2) {
-			colLookup.push_back(cp >> 8);
-			cp = 0;
+	uint64_t table[decode4TableSize];
+	buildDecode4Table(pal, table);
+	return decode4(buf, bufLen, out, outLen, table);
+}
+
+/* The fixed part of the colour pair table only depends on the palette, so
+ * callers decoding many previews can build it once
+ */
+void MapReader::buildDecode4Table(Palette const& pal, uint64_t* table) {
+	uint8_t rgb[6];
+	for(unsigned int i = 0; i != decode4TableSize; i++) {
+		pal.getRGB(i * 2, rgb[0], rgb[1], rgb[2]);
+		pal.getRGB(i * 2 + 1, rgb[3], rgb[4], rgb[5]);
+		uint64_t cp = 0;
+		for(unsigned int j = 0; j != 6; j++) {
+			cp = (cp << 8) | rgb[j];
 		}
+		table[i] = cp;
 	}
+}
+
+size_t MapReader::decode4(uint16_t const* buf, size_t bufLen, uint8_t* out, size_t outLen, uint64_t const* table) {
 	size_t bufPos = 0;
 	uint16_t numColours = buf[bufPos++];
 	if(bufPos + (numColours * 6) >= bufLen) {
-		throw EXCEPTION("Reading %u additional colour pairs would overrun input data");
+		throw EXCEPTION("Reading %u additional colour pairs would overrun input data", numColours);
 	}
 	EDEBUG("Reading %u additional colour pairs", numColours);
+	std::vector<uint64_t> colLookup(decode4TableSize + numColours);
+	memcpy(&colLookup[0], table, decode4TableSize * sizeof(uint64_t));
 	for(unsigned int i = 0; i != numColours; i++) {
+		uint64_t cp = 0;
 		for(unsigned int j = 0; j != 6; j++) {
-			cp |= buf[bufPos++];
-			cp <<= 8;
+			cp = (cp << 8) | buf[bufPos++];
 		}
-		colLookup.push_back(cp >> 8);
-		cp = 0;
+		colLookup[decode4TableSize + i] = cp;
 	}
 	if(bufPos >= bufLen) {
 		throw EXCEPTION("Overran data when reading additional palette data");
 	}
+	if((bufLen - bufPos) * 6 > outLen) {
+		throw EXCEPTION("Overran output buffer when decoding");
+	}
 	size_t outPos = 0;
-	uint16_t lookup;
 	while(bufPos != bufLen) {
-		lookup = buf[bufPos++];
+		uint16_t lookup = buf[bufPos++];
+		uint64_t cp = 0;
 		if(lookup >= colLookup.size()) {
 			ERROR("Position %lu - Cannot lookup colour pair %u as there are only %lu pairs in table",
 				bufPos - 1, lookup, colLookup.size());
-			cp = 0;
 		} else {
 			cp = colLookup[lookup];
 		}
-		if(outPos + 6 >= outLen) {
-			throw EXCEPTION("Overran output buffer when decoding");
-		}
-		out[outPos++] = cp >> 40 & 0xFF;
-		out[outPos++] = cp >> 32 & 0xFF;
-		out[outPos++] = cp >> 24 & 0xFF;
-		out[outPos++] = cp >> 16 & 0xFF;
-		out[outPos++] = cp >> 8 & 0xFF;
-		out[outPos++] = cp & 0xFF;
+		out[outPos] = cp >> 40;
+		out[outPos + 1] = cp >> 32;
+		out[outPos + 2] = cp >> 24;
+		out[outPos + 3] = cp >> 16;
+		out[outPos + 4] = cp >> 8;
+		out[outPos + 5] = cp;
+		outPos += 6;
 	}
 	return outPos;
 }
 
+/* Pack data has no alignment, memcpy lets the compiler pick the right load */
+static uint16_t read16(uint8_t const* buf) {
+	uint16_t v;
+	memcpy(&v, buf, sizeof(v));
+	return v;
+}
+
 void MapReader::readIsoMapPack(uint8_t* isoData, size_t len) {
 	if(len % 11 != 0) {
 		ERROR("%s", "isoData is not a multiple of 11 bytes long");
@@ -93,11 +112,11 @@ void MapReader::readIsoMapPack(uint8_t* isoData, size_t len) {
 	entry = new Entry[numEntries];
 	uint8_t* cur = isoData;
 	for(uint32_t i = 0; i != numEntries; i++) {
-		entry[i].x = *reinterpret_cast<uint16_t const*>(cur);
+		entry[i].x = read16(cur);
 		cur += 2;
-		entry[i].y = *reinterpret_cast<uint16_t const*>(cur);
+		entry[i].y = read16(cur);
 		cur += 2;
-		entry[i].tile = *reinterpret_cast<uint16_t const*>(cur);
+		entry[i].tile = read16(cur);
 		cur += 2;
 		entry[i].zero1[0] = *cur++;
 		entry[i].zero1[1] = *cur++;
@@ -107,11 +126,11 @@ void MapReader::readIsoMapPack(uint8_t* isoData, size_t len) {
 	}
 }
 
-static uint16_t read16(uint8_t const* buf) {
-	return *reinterpret_cast<uint16_t const*>(buf);
-}
-
-size_t MapReader::decode80(uint8_t const* in, uint8_t* out, size_t inLen, size_t outLen) {
+/* The straightforward byte at a time decoder, decode80 is an optimised
+ * version of this which is checked against it by f80_bench.  It does no
+ * per-command logging so that debug builds can check and time it too
+ */
+size_t MapReader::decode80Reference(uint8_t const* in, uint8_t* out, size_t inLen, size_t outLen) {
 	size_t inpos = 0, outpos = 0;
 
 	uint8_t cmd, byte;
@@ -125,55 +144,30 @@ size_t MapReader::decode80(uint8_t const* in, uint8_t* out, size_t inLen, size_t
 			pos = read16(&in[inpos]);
 			inpos += 2;
 			action = 0;
-			EDEBUG("in %lu / %lu, out %lu / %lu [CMD %02X c16a16 - COPY %lu from %lu]",
-				inpos, inLen, outpos, outLen,
-				cmd, count, pos
-			);
 		} else if(cmd == 0xFE) { // write count16 pixel8's
 			count = read16(&in[inpos]);
 			inpos += 2;
 			byte = in[inpos++];
 			action = 2;
-			EDEBUG("in %lu / %lu, out %lu / %lu [CMD %02X c16w8 - WRITE %lu 0x%02X]",
-				inpos, inLen, outpos, outLen,
-				cmd, count, byte
-			);
 		} else if((cmd & 0xC0) == 0xC0) { // copy (count6 + 3) from abs pos16
 			count = cmd & 0x3F;
 			count += 3;
 			pos = read16(&in[inpos]);
 			inpos += 2;
 			action = 0;
-			EDEBUG("in %lu / %lu, out %lu / %lu [CMD %02X c6a16 - COPY %lu from %lu]",
-				inpos, inLen, outpos, outLen,
-				cmd, count, pos
-			);
 		} else if((cmd & 0xC0) == 0x80) { // copy count6 bytes from source
 			count = cmd & 0x3F;
 			action = 1;
 			if(count == 0) {
-				EDEBUG("in %lu / %lu, out %lu / %lu [CMD %02X terminate]",
-					inpos, inLen, outpos, outLen,
-					cmd
-				);
 				break;
-			} else {
-				EDEBUG("in %lu / %lu, out %lu / %lu [CMD %02X c6s - COPY %lu from source]",
-					inpos, inLen, outpos, outLen,
-					cmd, count
-				);
 			}
 		} else if((cmd & 0x80) == 0x00) { // copy (count3 + 3) from rel pos12
 			count = (cmd & 0x70) >> 4;
 			count += 3;
-			pos = (cmd & 0x0F) << 4;
+			pos = (cmd & 0x0F) << 8;
 			pos |= in[inpos++];
 			pos = outpos - pos;
 			action = 0;
-			EDEBUG("in %lu / %lu, out %lu / %lu [CMD %02X c3r12 - COPY %lu from %lu]",
-				inpos, inLen, outpos, outLen,
-				cmd, count, pos
-			);
 		} else {
 			throw EXCEPTION("Unknown command 0x%02X", cmd);
 		}
@@ -218,7 +212,363 @@ size_t MapReader::decode80(uint8_t const* in, uint8_t* out, size_t inLen, size_t
 	return outpos;
 }
 
-uint8_t* MapReader::unpack(uint8_t const* in, size_t inLen, size_t& outLen, int format) {
+/* Same format as decode80Reference, but each command is checked once and
+ * then done in bulk: fills are a memset, non-overlapping copies a memcpy
+ * and overlapping copies go a word at a time where the distance allows.
+ * Unlike the reference decoder, truncated commands and copies from the
+ * part of the output not yet written are errors rather than reading
+ * whatever is there
+ */
+size_t MapReader::decode80(uint8_t const* in, uint8_t* out, size_t inLen, size_t outLen) {
+	uint8_t const* ip = in;
+	uint8_t const* ie = in + inLen;
+	uint8_t* op = out;
+	uint8_t* oe = out + outLen;
+	size_t count, pos;
+	while(ip < ie) {
+		uint8_t cmd = *ip++;
+		if((cmd & 0xC0) == 0x80) { // copy count6 bytes from source
+			count = cmd & 0x3F;
+			if(count == 0) {
+				break;
+			}
+			if(static_cast<size_t>(ie - ip) < count) {
+				throw EXCEPTION("Cannot copy %lu bytes from source, would overflow", count);
+			}
+			if(static_cast<size_t>(oe - op) < count) {
+				throw EXCEPTION("Cannot write %lu bytes to output, (position = %lu, length = %lu)",
+					count, op - out, outLen
+				);
+			}
+			memcpy(op, ip, count);
+			ip += count;
+			op += count;
+			continue;
+		}
+		if(cmd == 0xFE) { // write count16 pixel8's
+			if(ie - ip < 3) {
+				throw EXCEPTION("Fill command truncated at input position %lu", ip - in - 1);
+			}
+			count = read16(ip);
+			uint8_t byte = ip[2];
+			ip += 3;
+			if(static_cast<size_t>(oe - op) < count) {
+				throw EXCEPTION("Cannot write %lu bytes to output, (position = %lu, length = %lu)",
+					count, op - out, outLen
+				);
+			}
+			memset(op, byte, count);
+			op += count;
+			continue;
+		}
+		if(cmd == 0xFF) { // copy count16 from abs pos16
+			if(ie - ip < 4) {
+				throw EXCEPTION("Copy command truncated at input position %lu", ip - in - 1);
+			}
+			count = read16(ip);
+			pos = read16(ip + 2);
+			ip += 4;
+		} else if((cmd & 0xC0) == 0xC0) { // copy (count6 + 3) from abs pos16
+			if(ie - ip < 2) {
+				throw EXCEPTION("Copy command truncated at input position %lu", ip - in - 1);
+			}
+			count = (cmd & 0x3F) + 3;
+			pos = read16(ip);
+			ip += 2;
+		} else { // copy (count3 + 3) from rel pos12
+			if(ip == ie) {
+				throw EXCEPTION("Copy command truncated at input position %lu", ip - in - 1);
+			}
+			count = ((cmd & 0x70) >> 4) + 3;
+			size_t rel = ((cmd & 0x0F) << 8) | *ip++;
+			if(rel > static_cast<size_t>(op - out)) {
+				throw EXCEPTION("Cannot copy %lu bytes from %li bytes before the start of the buffer",
+					count, static_cast<long>(rel) - (op - out)
+				);
+			}
+			pos = (op - out) - rel;
+		}
+		if(pos >= static_cast<size_t>(op - out)) {
+			throw EXCEPTION("Cannot copy %lu bytes from %lu, only %lu bytes written so far",
+				count, pos, op - out
+			);
+		}
+		if(static_cast<size_t>(oe - op) < count) {
+			throw EXCEPTION("Cannot write %lu bytes to output, (position = %lu, length = %lu)",
+				count, op - out, outLen
+			);
+		}
+		uint8_t const* src = out + pos;
+		size_t dist = op - src;
+		if(dist >= count) {
+			memcpy(op, src, count);
+			op += count;
+		} else if(dist == 1) {
+			memset(op, *src, count);
+			op += count;
+		} else if(dist >= sizeof(uint64_t)) {
+			/* Each word only reads bytes at least a word behind */
+			uint8_t* end = op + count;
+			while(end - op >= static_cast<long>(sizeof(uint64_t))) {
+				uint64_t w;
+				memcpy(&w, src, sizeof(w));
+				memcpy(op, &w, sizeof(w));
+				src += sizeof(w);
+				op += sizeof(w);
+			}
+			while(op != end) {
+				*op++ = *src++;
+			}
+		} else {
+			for(uint8_t* end = op + count; op != end; ) {
+				*op++ = *src++;
+			}
+		}
+	}
+	return op - out;
+}
+
+/* Every command the encoder emits is at least a byte shorter than the input
+ * it covers, which pays for the header of the literal run before it, so only
+ * the literal headers of the last run and the terminator can grow the data
+ */
+size_t MapReader::maxEncoded80Size(size_t inLen) {
+	return inLen + (inLen + 62) / 63 + 1;
+}
+
+namespace {
+	uint32_t const hashBits = 15;
+	unsigned int const maxChain = 48;
+
+	uint32_t hash3(uint8_t const* p) {
+		uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+		return (v * 2654435761u) >> (32 - hashBits);
+	}
+
+	void need(uint8_t const* op, uint8_t const* end, size_t n) {
+		if(static_cast<size_t>(end - op) < n) {
+			throw EXCEPTION("Format80 output overflows its %lu byte buffer", static_cast<size_t>(end - op));
+		}
+	}
+
+	void flushLiterals(uint8_t const* lit, size_t n, uint8_t*& op, uint8_t const* end) {
+		need(op, end, n + (n + 62) / 63);
+		while(n != 0) {
+			size_t chunk = n < 63 ? n : 63;
+			*op++ = 0x80 | chunk;
+			memcpy(op, lit, chunk);
+			op += chunk;
+			lit += chunk;
+			n -= chunk;
+		}
+	}
+
+	void put16(uint8_t*& op, size_t v) {
+		*op++ = v & 0xFF;
+		*op++ = v >> 8;
+	}
+}
+
+/* Greedy Format80 encoder.  Byte runs become fills, otherwise the longest
+ * earlier match is found by following hash chains of 3 byte prefixes and
+ * written with the shortest command that can express it.  Sections are at
+ * most 64K so every earlier position can be reached with an absolute copy,
+ * but a 3 byte match is only worth a command when the relative form can
+ * reach it, otherwise it is left as literals.
+ * out must have room for maxEncoded80Size(inLen) bytes
+ */
+size_t MapReader::encode80(uint8_t const* in, uint8_t* out, size_t inLen, size_t outLen) {
+	if(inLen > 0xFFFF) {
+		throw EXCEPTION("Cannot Format80 encode %lu bytes, the limit is 65535", inLen);
+	}
+	if(outLen < maxEncoded80Size(inLen)) {
+		throw EXCEPTION("Output buffer of %lu bytes may be too small to encode %lu bytes", outLen, inLen);
+	}
+	std::vector<int32_t> head(1 << hashBits, -1);
+	std::vector<int32_t> prev(inLen);
+	uint8_t* op = out;
+	uint8_t const* end = out + outLen;
+	size_t lit = 0;
+	size_t i = 0;
+	size_t inserted = 0;
+	while(i < inLen) {
+		size_t left = inLen - i;
+		size_t run = 1;
+		while(run != left && run != 0xFFFF && in[i + run] == in[i]) {
+			run++;
+		}
+		size_t bestLen = 0, bestPos = 0;
+		if(left >= 3) {
+			while(inserted < i) {
+				if(inserted + 3 <= inLen) {
+					uint32_t h = hash3(in + inserted);
+					prev[inserted] = head[h];
+					head[h] = inserted;
+				}
+				inserted++;
+			}
+			size_t maxLen = left < 0xFFFF ? left : 0xFFFF;
+			int32_t cand = head[hash3(in + i)];
+			for(unsigned int depth = 0; cand != -1 && depth != maxChain; depth++, cand = prev[cand]) {
+				uint8_t const* c = in + cand;
+				if(c[bestLen] != in[i + bestLen]) {
+					continue;
+				}
+				size_t len = 0;
+				while(len != maxLen && c[len] == in[i + len]) {
+					len++;
+				}
+				if(len > bestLen) {
+					bestLen = len;
+					bestPos = cand;
+					if(len == maxLen) {
+						break;
+					}
+				}
+			}
+		}
+		if(run >= 5 && run >= bestLen) {
+			flushLiterals(in + i - lit, lit, op, end);
+			lit = 0;
+			need(op, end, 4);
+			*op++ = 0xFE;
+			put16(op, run);
+			*op++ = in[i];
+			i += run;
+			continue;
+		}
+		/* The 3 byte absolute copy would be no shorter than the literals */
+		if(bestLen < 3 || (bestLen == 3 && i - bestPos > 0xFFF)) {
+			lit++;
+			i++;
+			continue;
+		}
+		flushLiterals(in + i - lit, lit, op, end);
+		lit = 0;
+		size_t dist = i - bestPos;
+		if(bestLen <= 10 && dist <= 0xFFF) {
+			need(op, end, 2);
+			*op++ = ((bestLen - 3) << 4) | (dist >> 8);
+			*op++ = dist & 0xFF;
+		} else if(bestLen <= 64) {
+			need(op, end, 3);
+			*op++ = 0xC0 | (bestLen - 3);
+			put16(op, bestPos);
+		} else {
+			need(op, end, 5);
+			*op++ = 0xFF;
+			put16(op, bestLen);
+			put16(op, bestPos);
+		}
+		i += bestLen;
+	}
+	flushLiterals(in + i - lit, lit, op, end);
+	need(op, end, 1);
+	*op++ = 0x80;
+	return op - out;
+}
+
+namespace {
+	struct PackTask : public WorkQueue::Task {
+		uint8_t const* in;
+		size_t inLen;
+		size_t sectionSize;
+		int format;
+		std::vector<std::vector<uint8_t> > packed;
+
+		PackTask(uint8_t const* i, size_t l, size_t s, int f) :
+				in(i), inLen(l), sectionSize(s), format(f), packed((l + s - 1) / s) {
+		}
+
+		void run(size_t i) {
+			size_t start = i * sectionSize;
+			size_t len = inLen - start < sectionSize ? inLen - start : sectionSize;
+			std::vector<uint8_t>& out = packed[i];
+			size_t sz;
+			if(format == MapReader::LZOPack) {
+				out.resize(LZOCompress::maxCompressedSize(len));
+				sz = LZOCompress::compress(in + start, &out[0], len, out.size());
+			} else {
+				out.resize(MapReader::maxEncoded80Size(len));
+				sz = MapReader::encode80(in + start, &out[0], len, out.size());
+			}
+			if(sz > len) {
+				throw EXCEPTION("Section %lu does not compress (%lu bytes to %lu)", i, len, sz);
+			}
+			out.resize(sz);
+		}
+	};
+}
+
+/* The inverse of unpack, splits the data into sections of sectionSize bytes
+ * and compresses them in parallel.  A section can't be stored uncompressed
+ * so data that doesn't compress at all can't be packed
+ */
+uint8_t* MapReader::pack(uint8_t const* in, size_t inLen, size_t& outLen, int format, size_t sectionSize, unsigned int threads) {
+	if(format != LZOPack && format != F80Pack) {
+		throw EXCEPTION("Unknown pack compression format %i", format);
+	}
+	if(sectionSize == 0 || sectionSize > 0xFFFF) {
+		throw EXCEPTION("Invalid pack section size %lu", sectionSize);
+	}
+	PackTask task(in, inLen, sectionSize, format);
+	WorkQueue::run(task, task.packed.size(), threads);
+	outLen = 0;
+	for(size_t i = 0; i != task.packed.size(); i++) {
+		outLen += 4 + task.packed[i].size();
+	}
+	uint8_t* out = new uint8_t[outLen];
+	uint8_t* cur = out;
+	for(size_t i = 0; i != task.packed.size(); i++) {
+		size_t len = inLen - i * sectionSize < sectionSize ? inLen - i * sectionSize : sectionSize;
+		put16(cur, task.packed[i].size());
+		put16(cur, len);
+		if(!task.packed[i].empty()) {
+			memcpy(cur, &task.packed[i][0], task.packed[i].size());
+		}
+		cur += task.packed[i].size();
+	}
+	return out;
+}
+
+namespace {
+	/* Every section's output position is known up front, so they can all be
+	 * decompressed independently
+	 */
+	struct UnpackTask : public WorkQueue::Task {
+		std::vector<MapReader::PackSectionInfo> const& sections;
+		std::vector<size_t> offset;
+		uint8_t* out;
+		int format;
+
+		UnpackTask(std::vector<MapReader::PackSectionInfo> const& s, uint8_t* o, int f) :
+				sections(s), offset(s.size()), out(o), format(f) {
+			size_t pos = 0;
+			for(size_t i = 0; i != sections.size(); i++) {
+				offset[i] = pos;
+				pos += sections[i].unpackedLen;
+			}
+		}
+
+		void run(size_t i) {
+			MapReader::PackSectionInfo const& section = sections[i];
+			size_t sz;
+			if(format == MapReader::LZOPack) {
+				sz = LZODecompress::decompressFast(section.packedData, out + offset[i], section.packedLen, section.unpackedLen);
+			} else {
+				sz = MapReader::decode80(section.packedData, out + offset[i], section.packedLen, section.unpackedLen);
+			}
+			if(sz != section.unpackedLen) {
+				throw EXCEPTION("Wanted %u bytes of data, only %lu unpacked", section.unpackedLen, sz);
+			}
+		}
+	};
+}
+
+/* Sections are decompressed in parallel (threads == 0 means one per CPU),
+ * errors are reported for the first bad section whatever the scheduling
+ */
+uint8_t* MapReader::unpack(uint8_t const* in, size_t inLen, size_t& outLen, int format, unsigned int threads) {
 	typedef std::vector<PackSectionInfo> SectionVec;
 
 	PackSectionInfo section;
@@ -249,22 +599,16 @@ uint8_t* MapReader::unpack(uint8_t const* in, size_t inLen, size_t& outLen, int
 		outLen += section.unpackedLen;
 		sections.push_back(section);
 	}
+	if(format != LZOPack && format != F80Pack) {
+		throw EXCEPTION("Unknown pack compression format %i", format);
+	}
 	uint8_t* out = new uint8_t[outLen];
-	size_t sz;
-	uint8_t* curOut = out;
-	for(SectionVec::iterator it = sections.begin(); it != sections.end(); it++) {
-		if(format == LZOPack) {
-			sz = LZODecompress::decompress(it->packedData, curOut, it->packedLen, it->unpackedLen);
-		} else if(format == F80Pack) {
-			sz = decode80(it->packedData, curOut, it->packedLen, it->unpackedLen);
-		} else {
-			throw EXCEPTION("Unknown pack compression format %i", format);
-		}
-		curOut += sz;
-		if(sz != it->unpackedLen) {
-			delete[] out;
-			throw EXCEPTION("Wanted %u bytes of data, only %lu unpacked", it->unpackedLen, sz);
-		}
+	UnpackTask task(sections, out, format);
+	try {
+		WorkQueue::run(task, sections.size(), threads);
+	} catch(...) {
+		delete[] out;
+		throw;
 	}
 	return out;
 }
@@ -0,0 +1,486 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "MapRenderer.h"
+#include "WorkQueue.h"
+#include "Exception.h"
+#include <algorithm>
+#include <string.h>
+
+int32_t const MapRenderer::levelHeight = TMPFile::ra2TileHeight / 2;
+
+namespace {
+	struct PainterOrder {
+		MapReader::Entry const* entry;
+		PainterOrder(MapReader::Entry const* e) : entry(e) { }
+		bool operator()(uint32_t a, uint32_t b) const {
+			int32_t da = entry[a].x + entry[a].y;
+			int32_t db = entry[b].x + entry[b].y;
+			if(da != db) {
+				return da < db;
+			}
+			return entry[a].x < entry[b].x;
+		}
+	};
+
+	struct BandTask : public WorkQueue::Task {
+		MapRenderer const& renderer;
+		uint8_t* img;
+		size_t scanWidth;
+		uint32_t bandHeight;
+		uint32_t height;
+		BandTask(MapRenderer const& r, uint8_t* i, size_t w, uint32_t bh, uint32_t h) :
+			renderer(r), img(i), scanWidth(w), bandHeight(bh), height(h) { }
+		void run(size_t band) {
+			int32_t y0 = band * bandHeight;
+			int32_t y1 = y0 + bandHeight;
+			if(y1 > static_cast<int32_t>(height)) {
+				y1 = height;
+			}
+			renderer.renderBand(img, scanWidth, y0, y1);
+		}
+	};
+
+	struct ThumbnailTask : public WorkQueue::Task {
+		MapRenderer const& renderer;
+		uint8_t* rgba;
+		TileMips const& mips;
+		unsigned int level;
+		uint32_t bandHeight;
+		uint32_t height;
+		ThumbnailTask(MapRenderer const& r, uint8_t* out, TileMips const& m, unsigned int l, uint32_t bh, uint32_t h) :
+			renderer(r), rgba(out), mips(m), level(l), bandHeight(bh), height(h) { }
+		void run(size_t band) {
+			int32_t y0 = band * bandHeight;
+			int32_t y1 = y0 + bandHeight;
+			if(y1 > static_cast<int32_t>(height)) {
+				y1 = height;
+			}
+			renderer.renderThumbnailBand(rgba, mips, level, y0, y1);
+		}
+	};
+
+	struct RegionTask : public WorkQueue::Task {
+		MapRenderer const& renderer;
+		uint8_t* img;
+		uint16_t* depth;
+		size_t scanWidth;
+		uint32_t regionSize;
+		uint32_t regionsX;
+		uint32_t width, height;
+		MapRenderer::RowBuckets rows;
+		RegionTask(MapRenderer const& r, uint8_t* i, uint16_t* d, size_t sw, uint32_t rs) :
+				renderer(r), img(i), depth(d), scanWidth(sw), regionSize(rs) {
+			renderer.getSize(width, height);
+			regionsX = (width + regionSize - 1) / regionSize;
+			renderer.bucketRows(regionSize, rows);
+		}
+		void run(size_t region) {
+			int32_t x0 = (region % regionsX) * regionSize;
+			int32_t y0 = (region / regionsX) * regionSize;
+			int32_t x1 = std::min<int32_t>(x0 + regionSize, width);
+			int32_t y1 = std::min<int32_t>(y0 + regionSize, height);
+			for(int32_t y = y0; y < y1; y++) {
+				memset(&img[y * scanWidth + x0], 0, x1 - x0);
+				memset(&depth[y * scanWidth + x0], 0, (x1 - x0) * sizeof(uint16_t));
+			}
+			std::vector<uint32_t> const& list = rows[region / regionsX];
+			for(std::vector<uint32_t>::const_iterator it = list.begin(); it != list.end(); it++) {
+				MapRenderer::Cell const& cell = renderer.getCell(*it);
+				if(cell.right > x0 && cell.left < x1) {
+					renderer.drawCellDepth(cell, &img[y0 * scanWidth + x0], &depth[y0 * scanWidth + x0],
+						scanWidth, x0, y0, x1, y1);
+				}
+			}
+		}
+	};
+
+	struct PaletteTask : public WorkQueue::Task {
+		uint8_t const* indexed;
+		uint8_t* rgba;
+		uint8_t lookup[256][4];
+		uint32_t width;
+		PaletteTask(uint8_t const* in, uint8_t* out, uint32_t w, Palette const& pal) :
+				indexed(in), rgba(out), width(w) {
+			for(unsigned int i = 0; i != 256; i++) {
+				pal.getRGB(i, lookup[i][0], lookup[i][1], lookup[i][2]);
+				/* Colour 0 is never drawn, so it marks the area outside the map */
+				lookup[i][3] = i == 0 ? 0 : 255;
+			}
+		}
+		void run(size_t row) {
+			uint8_t const* in = indexed + row * width;
+			uint8_t* out = rgba + row * width * 4;
+			for(uint32_t x = 0; x != width; x++) {
+				memcpy(out, lookup[in[x]], 4);
+				out += 4;
+			}
+		}
+	};
+}
+
+MapRenderer::MapRenderer(MapReader const& map, Theater const& t) : theater(t), width(0), height(0) {
+	std::vector<uint32_t> order;
+	order.reserve(map.numEntries);
+	for(uint32_t i = 0; i != map.numEntries; i++) {
+		order.push_back(i);
+	}
+	std::stable_sort(order.begin(), order.end(), PainterOrder(map.entry));
+
+	int32_t tileW = TMPFile::ra2TileWidth;
+	int32_t tileH = TMPFile::ra2TileHeight;
+	int32_t minX = 0, minY = 0, maxX = 0, maxY = 0, minDepth = 0;
+	Cell cell;
+	cells.reserve(order.size());
+	for(std::vector<uint32_t>::iterator it = order.begin(); it != order.end(); it++) {
+		MapReader::Entry const& e = map.entry[*it];
+		/* Tile -1 is used for the default clear tile */
+		uint16_t tile = e.tile == -1 ? 0 : static_cast<uint16_t>(e.tile);
+		cell.tmp = theater.getTile(tile);
+		cell.tile = tile;
+		cell.subTile = static_cast<uint8_t>(e.subTile);
+		if(cell.tmp == NULL || !cell.tmp->hasTile(cell.subTile)) {
+			continue;
+		}
+		cell.x = (e.x - e.y) * (tileW / 2);
+		cell.y = (e.x + e.y) * (tileH / 2) - static_cast<uint8_t>(e.z) * levelHeight;
+		cell.depth = (e.x + e.y) * (tileH / 2) + static_cast<uint8_t>(e.z) * levelHeight;
+		cell.left = cell.x;
+		cell.right = cell.x + tileW;
+		cell.top = cell.y;
+		cell.bottom = cell.y + tileH;
+		TMPFile::TileHeader const& th = cell.tmp->getTileHeader(cell.subTile);
+		if(th.hasExtra()) {
+			int32_t ex = cell.x + th.extraX - th.x;
+			int32_t ey = cell.y + th.extraY - th.y;
+			cell.left = std::min(cell.left, ex);
+			cell.right = std::max(cell.right, ex + static_cast<int32_t>(th.extraW));
+			cell.top = std::min(cell.top, ey);
+			cell.bottom = std::max(cell.bottom, ey + static_cast<int32_t>(th.extraH));
+		}
+		if(cells.empty() || cell.left < minX) {
+			minX = cell.left;
+		}
+		if(cells.empty() || cell.right > maxX) {
+			maxX = cell.right;
+		}
+		if(cells.empty() || cell.top < minY) {
+			minY = cell.top;
+		}
+		if(cells.empty() || cell.bottom > maxY) {
+			maxY = cell.bottom;
+		}
+		if(cells.empty() || cell.depth < minDepth) {
+			minDepth = cell.depth;
+		}
+		cells.push_back(cell);
+	}
+	if(cells.size() != map.numEntries) {
+		EWARN("%lu of %u cells have no template in this theater", map.numEntries - cells.size(), map.numEntries);
+	}
+	/* Move everything into image space */
+	for(CellVec::iterator it = cells.begin(); it != cells.end(); it++) {
+		it->x -= minX;
+		it->y -= minY;
+		it->left -= minX;
+		it->right -= minX;
+		it->depth -= minDepth;
+		it->top -= minY;
+		it->bottom -= minY;
+	}
+	width = maxX - minX;
+	height = maxY - minY;
+	/* Thumbnail pixels are aligned to the cell lattice rather than the image
+	 * origin, so that cells land on the phases TileMips was built for
+	 */
+	thumbX = minX & ((1 << TileMips::numLevels) - 1);
+	thumbY = minY & ((1 << TileMips::numLevels) - 1);
+	EDEBUG("Map image is %u x %u (%lu cells)", width, height, cells.size());
+}
+
+void MapRenderer::getSize(uint32_t& w, uint32_t& h) const {
+	w = width;
+	h = height;
+}
+
+size_t MapRenderer::numCells() const {
+	return cells.size();
+}
+
+MapRenderer::Cell const& MapRenderer::getCell(size_t n) const {
+	return cells[n];
+}
+
+namespace {
+	/* Copies the opaque pixels of a w x h image at (px, py) which fall inside
+	 * the rectangle [x0, x1) x [y0, y1), img points at (x0, y0)
+	 */
+	void blit(uint8_t const* src, int32_t w, int32_t h, int32_t px, int32_t py,
+			uint8_t* img, size_t scanWidth, int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+		int32_t sx = std::max(x0, px), ex = std::min(x1, px + w);
+		int32_t sy = std::max(y0, py), ey = std::min(y1, py + h);
+		if(sx >= ex) {
+			return;
+		}
+		for(int32_t y = sy; y < ey; y++) {
+			uint8_t const* s = &src[(y - py) * w + (sx - px)];
+			uint8_t* d = &img[(y - y0) * scanWidth + (sx - x0)];
+			for(int32_t x = 0; x != ex - sx; x++) {
+				if(s[x]) {
+					d[x] = s[x];
+				}
+			}
+		}
+	}
+}
+
+/* Draws the part of a cell that falls in the rectangle [x0, x1) x [y0, y1),
+ * img points at the image position (x0, y0)
+ */
+void MapRenderer::drawCell(Cell const& cell, uint8_t* img, size_t scanWidth, int32_t x0, int32_t y0, int32_t x1, int32_t y1) const {
+	TMPFile::TileHeader const& th = cell.tmp->getTileHeader(cell.subTile);
+	TMPFile::TileData const& td = cell.tmp->getTileData(cell.subTile);
+	blit(td.tile, TMPFile::ra2TileWidth, TMPFile::ra2TileHeight, cell.x, cell.y,
+		img, scanWidth, x0, y0, x1, y1);
+	if(th.hasExtra()) {
+		blit(td.extra, th.extraW, th.extraH, cell.x + th.extraX - th.x, cell.y + th.extraY - th.y,
+			img, scanWidth, x0, y0, x1, y1);
+	}
+}
+
+/* Lists, for each row of rowHeight pixels, the cells which touch that row,
+ * in painter order
+ */
+void MapRenderer::bucketRows(uint32_t rowHeight, RowBuckets& rows) const {
+	uint32_t numRows = (height + rowHeight - 1) / rowHeight;
+	rows.clear();
+	rows.resize(numRows);
+	for(size_t i = 0; i != cells.size(); i++) {
+		uint32_t first = std::max(cells[i].top, 0) / rowHeight;
+		uint32_t last = std::max(cells[i].bottom - 1, 0) / rowHeight;
+		for(uint32_t row = first; row <= last && row < numRows; row++) {
+			rows[row].push_back(i);
+		}
+	}
+}
+
+/* Like blit, but each opaque pixel is only drawn if its depth (base plus the
+ * pixel's Z value, if there is Z data) is at least that already in the depth
+ * buffer.  Ties go to the pixel drawn last
+ */
+void MapRenderer::drawDepth(uint8_t const* src, uint8_t const* z, int32_t w, int32_t h, int32_t px, int32_t py, int32_t base,
+		uint8_t* img, uint16_t* depth, size_t scanWidth, int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+	int32_t sx = std::max(x0, px), ex = std::min(x1, px + w);
+	int32_t sy = std::max(y0, py), ey = std::min(y1, py + h);
+	if(sx >= ex) {
+		return;
+	}
+	for(int32_t y = sy; y < ey; y++) {
+		size_t so = (y - py) * w + (sx - px);
+		size_t dO = (y - y0) * scanWidth + (sx - x0);
+		uint8_t const* s = &src[so];
+		uint8_t const* sz = z ? &z[so] : NULL;
+		uint8_t* d = &img[dO];
+		uint16_t* dz = &depth[dO];
+		for(int32_t x = 0; x != ex - sx; x++) {
+			if(s[x]) {
+				int32_t pz = base + (sz ? sz[x] : 0);
+				if(pz > 0xFFFF) {
+					pz = 0xFFFF;
+				}
+				if(pz >= dz[x]) {
+					d[x] = s[x];
+					dz[x] = pz;
+				}
+			}
+		}
+	}
+}
+
+void MapRenderer::drawCellDepth(Cell const& cell, uint8_t* img, uint16_t* depth, size_t scanWidth, int32_t x0, int32_t y0, int32_t x1, int32_t y1) const {
+	TMPFile::TileHeader const& th = cell.tmp->getTileHeader(cell.subTile);
+	TMPFile::TileData const& td = cell.tmp->getTileData(cell.subTile);
+	drawDepth(td.tile, td.height, TMPFile::ra2TileWidth, TMPFile::ra2TileHeight, cell.x, cell.y, cell.depth,
+		img, depth, scanWidth, x0, y0, x1, y1);
+	if(th.hasExtra()) {
+		drawDepth(td.extra, td.extraHeight, th.extraW, th.extraH,
+			cell.x + th.extraX - th.x, cell.y + th.extraY - th.y, cell.depth,
+			img, depth, scanWidth, x0, y0, x1, y1);
+	}
+}
+
+/* Renders the whole map using the depth buffer, depth must have the same
+ * layout as img.  Other things (overlays, units) can be composited
+ * afterwards with drawDepth without needing to be sorted against the
+ * terrain
+ */
+void MapRenderer::renderDepth(uint8_t* img, uint16_t* depth, size_t scanWidth, unsigned int threads) const {
+	if(scanWidth < width) {
+		throw EXCEPTION("Scan width %lu is smaller than the map width %u", scanWidth, width);
+	}
+	if(width == 0 || height == 0) {
+		return;
+	}
+	RegionTask task(*this, img, depth, scanWidth, 128);
+	WorkQueue::run(task, task.regionsX * task.rows.size(), threads);
+}
+
+/* Renders the rows [y0, y1) of the map, img points at the whole image */
+void MapRenderer::renderBand(uint8_t* img, size_t scanWidth, int32_t y0, int32_t y1) const {
+	if(scanWidth < width) {
+		throw EXCEPTION("Scan width %lu is smaller than the map width %u", scanWidth, width);
+	}
+	if(y0 < 0 || y1 > static_cast<int32_t>(height)) {
+		throw EXCEPTION("Band [%i %i) is outside the map (height %u)", y0, y1, height);
+	}
+	for(int32_t y = y0; y < y1; y++) {
+		memset(&img[y * scanWidth], 0, width);
+	}
+	for(CellVec::const_iterator it = cells.begin(); it != cells.end(); it++) {
+		if(it->bottom > y0 && it->top < y1) {
+			drawCell(*it, &img[y0 * scanWidth], scanWidth, 0, y0, width, y1);
+		}
+	}
+}
+
+void MapRenderer::render(uint8_t* img, size_t scanWidth, unsigned int threads) const {
+	if(threads == 0) {
+		threads = WorkQueue::numThreads();
+	}
+	/* A few bands per thread evens out the bands with lots of cliffs */
+	uint32_t bands = threads * 4;
+	uint32_t bandHeight = (height + bands - 1) / bands;
+	if(bandHeight == 0) {
+		return;
+	}
+	BandTask task(*this, img, scanWidth, bandHeight, height);
+	WorkQueue::run(task, (height + bandHeight - 1) / bandHeight, threads);
+}
+
+/* Renders into a width * height * 4 buffer of R, G, B, A bytes, using
+ * renderDepth rather than render if useDepth is set
+ */
+void MapRenderer::renderRGBA(uint8_t* rgba, Palette const& pal, unsigned int threads, bool useDepth) const {
+	std::vector<uint8_t> indexed(width * height);
+	if(indexed.empty()) {
+		return;
+	}
+	if(useDepth) {
+		std::vector<uint16_t> depth(width * height);
+		renderDepth(&indexed[0], &depth[0], width, threads);
+	} else {
+		render(&indexed[0], width, threads);
+	}
+	PaletteTask task(&indexed[0], rgba, width, pal);
+	WorkQueue::run(task, height, threads);
+}
+
+void MapRenderer::getThumbnailSize(unsigned int level, uint32_t& w, uint32_t& h) const {
+	w = (thumbX + width + (1 << level) - 1) >> level;
+	h = (thumbY + height + (1 << level) - 1) >> level;
+}
+
+namespace {
+	/* Blends the part of a mip image at (px, py) which falls in the rows
+	 * [y0, y1) over an RGBA image, using the image's coverage as alpha.  The
+	 * RGBA image is premultiplied (it starts out transparent black).  Edge
+	 * pixels of neighbouring cells cover different parts of the pixel, so
+	 * coverage adds up until the pixel is full rather than the newer pixel
+	 * only being laid over the uncovered fraction (disjoint over)
+	 */
+	void blend(uint8_t const* src, int32_t w, int32_t h, int32_t px, int32_t py,
+			uint8_t* rgba, int32_t width, int32_t y0, int32_t y1) {
+		int32_t sx = std::max(0, px), ex = std::min(width, px + w);
+		int32_t sy = std::max(y0, py), ey = std::min(y1, py + h);
+		for(int32_t y = sy; y < ey; y++) {
+			uint8_t const* s = &src[((y - py) * w + (sx - px)) * 4];
+			uint8_t* d = &rgba[(y * width + sx) * 4];
+			for(int32_t x = sx; x < ex; x++, s += 4, d += 4) {
+				uint32_t a = s[3];
+				if(a == 255) {
+					memcpy(d, s, 4);
+				} else if(a + d[3] <= 255) {
+					d[0] += (s[0] * a) / 255;
+					d[1] += (s[1] * a) / 255;
+					d[2] += (s[2] * a) / 255;
+					d[3] += a;
+				} else {
+					uint32_t da = d[3];
+					d[0] = (s[0] * a) / 255 + (d[0] * (255 - a)) / da;
+					d[1] = (s[1] * a) / 255 + (d[1] * (255 - a)) / da;
+					d[2] = (s[2] * a) / 255 + (d[2] * (255 - a)) / da;
+					d[3] = 255;
+				}
+			}
+		}
+	}
+}
+
+/* Renders the rows [y0, y1) of a thumbnail at the given mip level, rgba
+ * points at the whole thumbnail
+ */
+void MapRenderer::renderThumbnailBand(uint8_t* rgba, TileMips const& mips, unsigned int level, int32_t y0, int32_t y1) const {
+	uint32_t w, h;
+	getThumbnailSize(level, w, h);
+	memset(&rgba[y0 * w * 4], 0, (y1 - y0) * w * 4);
+	/* Cell extents are in full size pixels, thumbnail pixel (0, 0) covers
+	 * those from (-thumbX, -thumbY)
+	 */
+	int32_t fy0 = (y0 << level) - thumbY, fy1 = (y1 << level) - thumbY;
+	for(CellVec::const_iterator it = cells.begin(); it != cells.end(); it++) {
+		if(it->bottom <= fy0 || it->top >= fy1) {
+			continue;
+		}
+		int32_t x = it->x + thumbX, y = it->y + thumbY;
+		TileMips::Entry const* e = mips.getEntry(it->tile, it->subTile, level, x, y);
+		if(e == NULL) {
+			continue;
+		}
+		blend(mips.getPixels(e->tile, level), e->tile.w, e->tile.h,
+			(x + e->tile.x) >> level, (y + e->tile.y) >> level,
+			rgba, w, y0, y1);
+		if(e->extra.w) {
+			blend(mips.getPixels(e->extra, level), e->extra.w, e->extra.h,
+				(x + e->extra.x) >> level, (y + e->extra.y) >> level,
+				rgba, w, y0, y1);
+		}
+	}
+}
+
+/* Renders an RGBA thumbnail of getThumbnailSize(level) directly from the
+ * reduced size tiles, without drawing the full size map
+ */
+void MapRenderer::renderThumbnail(uint8_t* rgba, TileMips const& mips, unsigned int level, unsigned int threads) const {
+	if(level < 1 || level > TileMips::numLevels) {
+		throw EXCEPTION("Thumbnail level %u is out of range [1 %u]", level, TileMips::numLevels);
+	}
+	uint32_t w, h;
+	getThumbnailSize(level, w, h);
+	if(threads == 0) {
+		threads = WorkQueue::numThreads();
+	}
+	uint32_t bands = threads * 4;
+	uint32_t bandHeight = (h + bands - 1) / bands;
+	if(bandHeight == 0) {
+		return;
+	}
+	ThumbnailTask task(*this, rgba, mips, level, bandHeight, h);
+	WorkQueue::run(task, (h + bandHeight - 1) / bandHeight, threads);
+}
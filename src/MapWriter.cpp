@@ -0,0 +1,109 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "MapWriter.h"
+#include "MapReader.h"
+#include "Base64.h"
+#include "Utils.h"
+
+size_t const MapWriter::lineLength = 70;
+
+MapWriter::MapWriter(INIFile& i, unsigned int t) : ini(i), threads(t) {
+}
+
+/* The data is not copied, it has to stay around until the map is written */
+void MapWriter::setPack(std::string const& section, uint8_t const* data, size_t len, int format) {
+	Pack& p = packs[section];
+	p.data = data;
+	p.len = len;
+	p.format = format;
+	p.encoded.clear();
+}
+
+void MapWriter::encodePacks() {
+	for(PackMap::iterator it = packs.begin(); it != packs.end(); it++) {
+		Pack& p = it->second;
+		size_t packedLen;
+		Utils::ScopedArray<uint8_t> packed(MapReader::pack(p.data, p.len, packedLen, p.format, 8192, threads));
+		p.encoded.resize(Base64::encodedSize(packedLen));
+		if(!p.encoded.empty()) {
+			Base64::encode(packed.ptr, packedLen, reinterpret_cast<uint8_t*>(&p.encoded[0]));
+		}
+	}
+}
+
+/* Written as Key=Value like the game's own files */
+void MapWriter::writeSection(Utils::BufferedWrite& out, std::string const& name, INIFile::key_iterator it, INIFile::key_iterator end) {
+	out.write('[');
+	out.write(name);
+	out.write("]\n", 2);
+	for(; it != end; it++) {
+		out.write(it->first);
+		out.write('=');
+		out.write(it->second.str);
+		out.write('\n');
+	}
+	out.write('\n');
+}
+
+void MapWriter::writePack(Utils::BufferedWrite& out, std::string const& name, std::string const& encoded) {
+	out.write('[');
+	out.write(name);
+	out.write("]\n", 2);
+	char key[16];
+	unsigned int line = 1;
+	for(size_t pos = 0; pos < encoded.length(); pos += lineLength, line++) {
+		out.write(key, snprintf(key, sizeof(key), "%u=", line));
+		size_t len = encoded.length() - pos < lineLength ? encoded.length() - pos : lineLength;
+		out.write(encoded.data() + pos, len);
+		out.write('\n');
+	}
+	out.write('\n');
+}
+
+void MapWriter::write(std::string const& fn) {
+	FILE* f = fopen(fn.c_str(), "wb");
+	if(f == NULL) {
+		throw EXCEPTION("Could not open file \"%s\" for writing", fn.c_str());
+	}
+	Utils::ScopedFile closer(f);
+	write(f);
+}
+
+/* INI sections and packs are both in name order, so the output is sorted
+ * the same way INIFile::write sorts it
+ */
+void MapWriter::write(FILE* f) {
+	encodePacks();
+	Utils::BufferedWrite out(f, 1 << 20);
+	PackMap::const_iterator pack = packs.begin();
+	for(INIFile::section_iterator it = ini.sectionsBegin(); it != ini.sectionsEnd(); it++) {
+		for(; pack != packs.end() && pack->first <= it->first; pack++) {
+			writePack(out, pack->first, pack->second.encoded);
+		}
+		if(packs.find(it->first) == packs.end()) {
+			writeSection(out, it->first, it->second.begin(), it->second.end());
+		}
+	}
+	for(; pack != packs.end(); pack++) {
+		writePack(out, pack->first, pack->second.encoded);
+	}
+	out.flush();
+}
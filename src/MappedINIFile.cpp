@@ -0,0 +1,315 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "MappedINIFile.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+uint32_t const MappedINIFile::emptySlot = 0xFFFFFFFF;
+
+bool MappedINIFile::StringRef::equals(char const* s, size_t l) const {
+	return len == l && memcmp(str, s, l) == 0;
+}
+
+MappedINIFile::MappedINIFile(std::string const& fn) : data(NULL), size(0), currentSection(emptySlot) {
+	int fd = open(fn.c_str(), O_RDONLY);
+	if(fd == -1) {
+		throw EXCEPTION("Could not open file \"%s\" (%s)", fn.c_str(), strerror(errno));
+	}
+	struct stat st;
+	if(fstat(fd, &st) == -1) {
+		close(fd);
+		throw EXCEPTION("Could not stat file \"%s\" (%s)", fn.c_str(), strerror(errno));
+	}
+	size = st.st_size;
+	if(size != 0) {
+		void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(map == MAP_FAILED) {
+			close(fd);
+			throw EXCEPTION("Could not map file \"%s\" (%s)", fn.c_str(), strerror(errno));
+		}
+		madvise(map, size, MADV_SEQUENTIAL);
+		data = static_cast<char const*>(map);
+	}
+	close(fd);
+	try {
+		parse();
+	} catch(...) {
+		if(data != NULL) {
+			munmap(const_cast<char*>(data), size);
+		}
+		throw;
+	}
+}
+
+MappedINIFile::~MappedINIFile() {
+	if(data != NULL) {
+		munmap(const_cast<char*>(data), size);
+	}
+}
+
+/* FNV-1a */
+uint32_t MappedINIFile::hash(char const* s, size_t len, uint32_t h) {
+	for(size_t i = 0; i != len; i++) {
+		h ^= static_cast<uint8_t>(s[i]);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+void MappedINIFile::trim(char const*& start, char const*& end, char const* chars) {
+	while(start != end && strchr(chars, *start) != NULL) {
+		start++;
+	}
+	while(end != start && strchr(chars, end[-1]) != NULL) {
+		end--;
+	}
+}
+
+uint32_t MappedINIFile::lookupSection(char const* name, size_t len) const {
+	if(sectionTable.empty()) {
+		return emptySlot;
+	}
+	uint32_t mask = sectionTable.size() - 1;
+	for(uint32_t i = hash(name, len) & mask; sectionTable[i] != emptySlot; i = (i + 1) & mask) {
+		if(sections[sectionTable[i]].name.equals(name, len)) {
+			return sectionTable[i];
+		}
+	}
+	return emptySlot;
+}
+
+void MappedINIFile::placeSection(uint32_t idx) {
+	uint32_t mask = sectionTable.size() - 1;
+	uint32_t i = hash(sections[idx].name.str, sections[idx].name.len) & mask;
+	while(sectionTable[i] != emptySlot) {
+		i = (i + 1) & mask;
+	}
+	sectionTable[i] = idx;
+}
+
+uint32_t MappedINIFile::insertSection(char const* name, size_t len) {
+	uint32_t found = lookupSection(name, len);
+	if(found != emptySlot) {
+		return found;
+	}
+	Section s;
+	s.name = StringRef(name, len);
+	s.firstKey = 0;
+	s.numKeys = 0;
+	sections.push_back(s);
+	uint32_t idx = sections.size() - 1;
+	if(sections.size() * 2 > sectionTable.size()) {
+		sectionTable.assign(sectionTable.empty() ? 64 : sectionTable.size() * 2, emptySlot);
+		for(uint32_t i = 0; i <= idx; i++) {
+			placeSection(i);
+		}
+	} else {
+		placeSection(idx);
+	}
+	return idx;
+}
+
+uint32_t MappedINIFile::keyHash(uint32_t section, char const* key, size_t len) {
+	return hash(key, len, 2166136261u ^ (section * 0x9E3779B1u));
+}
+
+void MappedINIFile::parseLine(char const* p, char const* end) {
+	while(p != end && (*p == ' ' || *p == '\t')) {
+		p++;
+	}
+	if(p == end || *p == ';' || *p == '#') {
+		return;
+	}
+	if(*p == '[') {
+		char const* close = static_cast<char const*>(memchr(p + 1, ']', end - p - 1));
+		if(close != NULL) {
+			currentSection = insertSection(p + 1, close - p - 1);
+		}
+		return;
+	}
+	if(currentSection == emptySlot) {
+		throw EXCEPTION("No current section, input == \"%s\"", std::string(p, end).c_str());
+	}
+	char const* eq = static_cast<char const*>(memchr(p, '=', end - p));
+	if(eq == NULL) {
+		return;
+	}
+	char const* keyEnd = eq;
+	trim(p, keyEnd, " \n");
+	if(p == keyEnd) {
+		throw EXCEPTION("Empty key");
+	}
+	char const* val = eq + 1;
+	trim(val, end, " \t");
+	Key k;
+	k.key = StringRef(p, keyEnd - p);
+	k.value = StringRef(val, end - val);
+	k.section = currentSection;
+	keys.push_back(k);
+}
+
+/* Lines end at either '\n' or '\r', memchr does the scanning for the far
+ * more common '\n' and each line is then checked for a stray '\r'
+ */
+void MappedINIFile::parse() {
+	char const* p = data;
+	char const* end = data + size;
+	while(p < end) {
+		char const* nl = static_cast<char const*>(memchr(p, '\n', end - p));
+		char const* lineEnd = nl != NULL ? nl : end;
+		char const* cr;
+		while((cr = static_cast<char const*>(memchr(p, '\r', lineEnd - p))) != NULL) {
+			parseLine(p, cr);
+			p = cr + 1;
+		}
+		parseLine(p, lineEnd);
+		p = lineEnd + 1;
+	}
+	currentSection = emptySlot;
+	buildKeyTable();
+}
+
+/* Groups the keys by section (keeping file order within a section), drops
+ * repeated keys and builds the hash table over what is left
+ */
+void MappedINIFile::buildKeyTable() {
+	std::vector<uint32_t> start(sections.size() + 1, 0);
+	for(size_t i = 0; i != keys.size(); i++) {
+		start[keys[i].section + 1]++;
+	}
+	for(size_t i = 0; i != sections.size(); i++) {
+		start[i + 1] += start[i];
+	}
+	std::vector<Key> sorted(keys.size());
+	for(size_t i = 0; i != keys.size(); i++) {
+		sorted[start[keys[i].section]++] = keys[i];
+	}
+
+	uint32_t tableSize = 64;
+	while(tableSize < sorted.size() * 2) {
+		tableSize *= 2;
+	}
+	keyTable.assign(tableSize, emptySlot);
+	uint32_t mask = tableSize - 1;
+	uint32_t out = 0;
+	for(size_t i = 0; i != sorted.size(); i++) {
+		Key const& k = sorted[i];
+		uint32_t slot = keyHash(k.section, k.key.str, k.key.len) & mask;
+		bool duplicate = false;
+		for(; keyTable[slot] != emptySlot; slot = (slot + 1) & mask) {
+			Key const& other = sorted[keyTable[slot]];
+			if(other.section == k.section && other.key.equals(k.key.str, k.key.len)) {
+				duplicate = true;
+				break;
+			}
+		}
+		if(!duplicate) {
+			sorted[out] = k;
+			keyTable[slot] = out++;
+			sections[k.section].numKeys++;
+		}
+	}
+	sorted.resize(out);
+	keys.swap(sorted);
+	uint32_t first = 0;
+	for(size_t i = 0; i != sections.size(); i++) {
+		sections[i].firstKey = first;
+		first += sections[i].numKeys;
+	}
+}
+
+size_t MappedINIFile::numSections() const {
+	return sections.size();
+}
+
+std::string MappedINIFile::getSectionName(size_t i) const {
+	return sections.at(i).name.toString();
+}
+
+bool MappedINIFile::sectionExists(std::string const& section) const {
+	return lookupSection(section.data(), section.length()) != emptySlot;
+}
+
+void MappedINIFile::setCurrentSection(std::string const& section) {
+	uint32_t found = lookupSection(section.data(), section.length());
+	if(found == emptySlot) {
+		throw EXCEPTION("Section \"%s\" not found", section.c_str());
+	}
+	currentSection = found;
+}
+
+std::string MappedINIFile::getCurrentSectionName() const {
+	if(currentSection == emptySlot) {
+		throw EXCEPTION("No current section");
+	}
+	return sections[currentSection].name.toString();
+}
+
+bool MappedINIFile::findKey(char const* key, size_t len, StringRef& value) const {
+	if(currentSection == emptySlot) {
+		throw EXCEPTION("No current section");
+	}
+	uint32_t mask = keyTable.size() - 1;
+	for(uint32_t i = keyHash(currentSection, key, len) & mask; keyTable[i] != emptySlot; i = (i + 1) & mask) {
+		Key const& k = keys[keyTable[i]];
+		if(k.section == currentSection && k.key.equals(key, len)) {
+			value = k.value;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool MappedINIFile::findKey(std::string const& key, StringRef& value) const {
+	return findKey(key.data(), key.length(), value);
+}
+
+bool MappedINIFile::keyExists(std::string const& key) const {
+	StringRef value;
+	return findKey(key, value);
+}
+
+std::string MappedINIFile::getKey(std::string const& key) const {
+	StringRef value;
+	if(!findKey(key, value)) {
+		throw EXCEPTION("Key not found");
+	}
+	return value.toString();
+}
+
+/* Keys are in file order rather than sorted as with INIFile */
+MappedINIFile::key_iterator MappedINIFile::keysBegin() const {
+	if(currentSection == emptySlot) {
+		throw EXCEPTION("No current section");
+	}
+	return keys.empty() ? NULL : &keys[0] + sections[currentSection].firstKey;
+}
+
+MappedINIFile::key_iterator MappedINIFile::keysEnd() const {
+	if(currentSection == emptySlot) {
+		throw EXCEPTION("No current section");
+	}
+	return keysBegin() + sections[currentSection].numKeys;
+}
@@ -0,0 +1,235 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "OverlayGrid.h"
+#include "INIFile.h"
+#include "Exception.h"
+#include <stdio.h>
+#include <string.h>
+
+uint32_t const OverlayGrid::size = 512;
+uint8_t const OverlayGrid::noOverlay = 0xFF;
+
+uint8_t const OverlayGrid::None = 0;
+uint8_t const OverlayGrid::Ore = 1;
+uint8_t const OverlayGrid::Gem = 2;
+uint8_t const OverlayGrid::Wall = 3;
+size_t const OverlayGrid::classTableSize = 256;
+
+OverlayGrid::OverlayGrid(uint8_t const* overlayPack, size_t overlayLen, uint8_t const* dataPack, size_t dataLen) {
+	size_t n = static_cast<size_t>(size) * size;
+	if(overlayLen != n) {
+		throw EXCEPTION("OverlayPack is %lu bytes, expected %lu", overlayLen, n);
+	}
+	if(dataLen != n) {
+		throw EXCEPTION("OverlayDataPack is %lu bytes, expected %lu", dataLen, n);
+	}
+	overlay.assign(overlayPack, overlayPack + n);
+	data.assign(dataPack, dataPack + n);
+	defaultClasses(classes);
+}
+
+/* The stock [OverlayTypes] order: GEM01-12 are 27-38, then the riparius
+ * (TIB01-20), cruentus (TIB2_), vinifera (TIB3_) and aboreus (TIB4_)
+ * overlays.  Vinifera and aboreus are worth gem prices.  Walls need rules.
+ */
+void OverlayGrid::defaultClasses(uint8_t* classes) {
+	memset(classes, None, classTableSize);
+	memset(classes + 27, Gem, 12);
+	memset(classes + 102, Ore, 20);
+	memset(classes + 127, Ore, 20);
+	memset(classes + 147, Gem, 40);
+}
+
+/* Fills a classTableSize entry table from a rules file: Tiberium=yes
+ * overlays are resources (gems if they use a GEM, TIB3 or TIB4 image) and
+ * Wall=yes ones are walls.  Returns false, leaving the table alone, if
+ * there's no [OverlayTypes] section.  Build the table once and hand it to
+ * each grid with setClasses rather than sharing the INIFile between threads
+ */
+bool OverlayGrid::buildClasses(INIFile& rules, uint8_t* classes) {
+	if(!rules.sectionExists("OverlayTypes")) {
+		return false;
+	}
+	std::vector<std::string> names(noOverlay);
+	rules.setCurrentSection("OverlayTypes");
+	for(unsigned int i = 0; i != noOverlay; i++) {
+		char key[8];
+		snprintf(key, sizeof(key), "%u", i);
+		std::string const* name = rules.findKey(key);
+		if(name != NULL) {
+			names[i] = *name;
+		}
+	}
+	memset(classes, None, classTableSize);
+	for(unsigned int i = 0; i != noOverlay; i++) {
+		if(names[i].empty() || !rules.sectionExists(names[i])) {
+			continue;
+		}
+		rules.setCurrentSection(names[i]);
+		bool flag;
+		if(rules.getBool("Wall", flag) && flag) {
+			classes[i] = Wall;
+		} else if(rules.getBool("Tiberium", flag) && flag) {
+			std::string const* image = rules.findKey("Image");
+			std::string const& img = image != NULL ? *image : names[i];
+			if(img.compare(0, 3, "GEM") == 0 || img.compare(0, 4, "TIB3") == 0 || img.compare(0, 4, "TIB4") == 0) {
+				classes[i] = Gem;
+			} else {
+				classes[i] = Ore;
+			}
+		}
+	}
+	return true;
+}
+
+bool OverlayGrid::loadClasses(INIFile& rules) {
+	return buildClasses(rules, classes);
+}
+
+void OverlayGrid::setClasses(uint8_t const* table) {
+	memcpy(classes, table, classTableSize);
+}
+
+uint8_t OverlayGrid::getClass(uint8_t o) const {
+	return classes[o];
+}
+
+uint8_t OverlayGrid::getOverlay(uint32_t x, uint32_t y) const {
+	if(x >= size || y >= size) {
+		return noOverlay;
+	}
+	return overlay[y * size + x];
+}
+
+uint8_t OverlayGrid::getData(uint32_t x, uint32_t y) const {
+	if(x >= size || y >= size) {
+		return 0;
+	}
+	return data[y * size + x];
+}
+
+uint8_t const* OverlayGrid::getOverlayRow(uint32_t y) const {
+	return &overlay[y * size];
+}
+
+uint8_t const* OverlayGrid::getDataRow(uint32_t y) const {
+	return &data[y * size];
+}
+
+/* The amount is the sum of the growth stages plus one, so a fully grown
+ * patch counts 12 per cell.  The rectangle is clipped to the grid.
+ */
+OverlayGrid::ResourceCount OverlayGrid::countResources(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const {
+	ResourceCount count;
+	if(x >= size || y >= size) {
+		return count;
+	}
+	uint32_t endX = (w > size - x) ? size : x + w;
+	uint32_t endY = (h > size - y) ? size : y + h;
+	for(uint32_t cy = y; cy != endY; cy++) {
+		uint8_t const* o = &overlay[cy * size];
+		uint8_t const* d = &data[cy * size];
+		for(uint32_t cx = x; cx != endX; cx++) {
+			uint8_t c = classes[o[cx]];
+			if(c == Ore) {
+				count.oreCells++;
+				count.oreAmount += d[cx] + 1;
+			} else if(c == Gem) {
+				count.gemCells++;
+				count.gemAmount += d[cx] + 1;
+			}
+		}
+	}
+	return count;
+}
+
+/* Splits the grid into regionSize square blocks and counts each one in a
+ * single pass; regions are stored row-major and the number of regions per
+ * row is returned.
+ */
+uint32_t OverlayGrid::countResourcesByRegion(uint32_t regionSize, std::vector<ResourceCount>& regions) const {
+	if(regionSize == 0) {
+		throw EXCEPTION("Region size must be at least 1");
+	}
+	uint32_t across = (size + regionSize - 1) / regionSize;
+	regions.assign(static_cast<size_t>(across) * across, ResourceCount());
+	for(uint32_t y = 0; y != size; y++) {
+		uint8_t const* o = &overlay[y * size];
+		uint8_t const* d = &data[y * size];
+		ResourceCount* row = &regions[(y / regionSize) * across];
+		for(uint32_t x = 0; x != size; x++) {
+			uint8_t c = classes[o[x]];
+			if(c == Ore) {
+				row[x / regionSize].oreCells++;
+				row[x / regionSize].oreAmount += d[x] + 1;
+			} else if(c == Gem) {
+				row[x / regionSize].gemCells++;
+				row[x / regionSize].gemAmount += d[x] + 1;
+			}
+		}
+	}
+	return across;
+}
+
+/* A segment is a 4-connected group of cells with the same wall overlay,
+ * listed in the order their first cell appears scanning row by row
+ */
+void OverlayGrid::listWalls(std::vector<WallSegment>& segments) const {
+	segments.clear();
+	std::vector<uint8_t> seen(overlay.size(), 0);
+	std::vector<uint32_t> stack;
+	for(uint32_t i = 0; i != overlay.size(); i++) {
+		uint8_t o = overlay[i];
+		if(seen[i] || classes[o] != Wall) {
+			continue;
+		}
+		WallSegment seg;
+		seg.overlay = o;
+		seg.cells = 0;
+		seg.firstX = seg.minX = seg.maxX = i % size;
+		seg.firstY = seg.minY = seg.maxY = i / size;
+		seen[i] = 1;
+		stack.push_back(i);
+		while(!stack.empty()) {
+			uint32_t c = stack.back();
+			stack.pop_back();
+			uint16_t x = c % size, y = c / size;
+			seg.cells++;
+			if(x < seg.minX) seg.minX = x;
+			if(x > seg.maxX) seg.maxX = x;
+			if(y < seg.minY) seg.minY = y;
+			if(y > seg.maxY) seg.maxY = y;
+			uint32_t next[4];
+			unsigned int n = 0;
+			if(x > 0) next[n++] = c - 1;
+			if(x < size - 1) next[n++] = c + 1;
+			if(y > 0) next[n++] = c - size;
+			if(y < size - 1) next[n++] = c + size;
+			for(unsigned int j = 0; j != n; j++) {
+				if(!seen[next[j]] && overlay[next[j]] == o) {
+					seen[next[j]] = 1;
+					stack.push_back(next[j]);
+				}
+			}
+		}
+		segments.push_back(seg);
+	}
+}
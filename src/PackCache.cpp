@@ -0,0 +1,112 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "PackCache.h"
+#include "Base64.h"
+#include "INIFile.h"
+#include "MapReader.h"
+#include "Exception.h"
+#include "Utils.h"
+#include <stdio.h>
+
+bool PackCache::Key::operator<(Key const& o) const {
+	if(hash != o.hash) {
+		return hash < o.hash;
+	}
+	if(textLen != o.textLen) {
+		return textLen < o.textLen;
+	}
+	if(format != o.format) {
+		return format < o.format;
+	}
+	return section < o.section;
+}
+
+PackCache::PackCache(size_t max) : maxBytes(max), totalBytes(0), uses(0), hits(0), misses(0) {
+}
+
+/* Returns the unpacked contents of a pack section, which must exist.  The
+ * key is the numbered lines joined together, that being all Base64::decode
+ * looks at; for a lazily read map they are found without parsing the
+ * section, so a hit doesn't parse it at all.  Either way the same pack has
+ * the same key
+ */
+uint8_t const* PackCache::get(INIFile& map, std::string const& section, int format, size_t& len, unsigned int threads) {
+	Key key;
+	key.section = section;
+	key.format = format;
+	key.hash = Utils::fnv1a64(NULL, 0);
+	key.textLen = 0;
+	map.getNumberedValues(section, pieces);
+	for(size_t i = 0; i != pieces.size(); i++) {
+		key.hash = Utils::fnv1a64(pieces[i].first, pieces[i].second, key.hash);
+		key.textLen += pieces[i].second;
+	}
+
+	EntryMap::iterator it = entries.find(key);
+	if(it != entries.end()) {
+		hits++;
+	} else {
+		misses++;
+		size_t packedLen, unpackedLen;
+		map.setCurrentSection(section);
+		Utils::ScopedArray<uint8_t> packed(Base64::decode(map, packedLen));
+		Utils::ScopedArray<uint8_t> unpacked(MapReader::unpack(packed.ptr, packedLen, unpackedLen, format, threads));
+		it = entries.insert(std::make_pair(key, Entry())).first;
+		it->second.data.assign(unpacked.ptr, unpacked.ptr + unpackedLen);
+		totalBytes += unpackedLen;
+		EDEBUG("Unpacked [%s], %lu bytes in %lu packs cached", section.c_str(), totalBytes, entries.size());
+	}
+	it->second.lastUse = ++uses;
+	evict(it);
+	len = it->second.data.size();
+	return len == 0 ? NULL : &it->second.data[0];
+}
+
+/* There are only ever a handful of entries, a scan for the oldest is fine */
+void PackCache::evict(EntryMap::iterator keep) {
+	while(totalBytes > maxBytes && entries.size() > 1) {
+		EntryMap::iterator oldest = entries.end();
+		for(EntryMap::iterator it = entries.begin(); it != entries.end(); it++) {
+			if(it != keep && (oldest == entries.end() || it->second.lastUse < oldest->second.lastUse)) {
+				oldest = it;
+			}
+		}
+		totalBytes -= oldest->second.data.size();
+		entries.erase(oldest);
+	}
+}
+
+void PackCache::clear() {
+	entries.clear();
+	totalBytes = 0;
+}
+
+size_t PackCache::size() const {
+	return totalBytes;
+}
+
+unsigned long PackCache::getHits() const {
+	return hits;
+}
+
+unsigned long PackCache::getMisses() const {
+	return misses;
+}
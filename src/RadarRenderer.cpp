@@ -0,0 +1,79 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "RadarRenderer.h"
+#include "Exception.h"
+#include <string.h>
+
+RadarRenderer::RadarRenderer(MapReader const& m) : map(m), minU(0), minV(0), width(0), height(0) {
+	int32_t maxU = 0, maxV = 0;
+	for(uint32_t i = 0; i != map.numEntries; i++) {
+		int32_t u = map.entry[i].x - map.entry[i].y;
+		int32_t v = map.entry[i].x + map.entry[i].y;
+		if(i == 0 || u < minU) {
+			minU = u;
+		}
+		if(i == 0 || u > maxU) {
+			maxU = u;
+		}
+		if(i == 0 || v < minV) {
+			minV = v;
+		}
+		if(i == 0 || v > maxV) {
+			maxV = v;
+		}
+	}
+	if(map.numEntries) {
+		width = maxU - minU + 2;
+		height = maxV - minV + 1;
+	}
+}
+
+void RadarRenderer::getSize(uint32_t& w, uint32_t& h) const {
+	w = width;
+	h = height;
+}
+
+/* Renders into a width * height * 4 buffer of R, G, B, A bytes, pixels not
+ * covered by any cell are left transparent
+ */
+void RadarRenderer::render(uint8_t* rgba, Theater const& theater) const {
+	memset(rgba, 0, width * height * 4);
+	uint32_t missing = 0;
+	for(uint32_t i = 0; i != map.numEntries; i++) {
+		MapReader::Entry const& e = map.entry[i];
+		uint16_t tile = e.tile == -1 ? 0 : static_cast<uint16_t>(e.tile);
+		uint8_t subTile = static_cast<uint8_t>(e.subTile);
+		TMPFile const* tmp = theater.getTile(tile);
+		if(tmp == NULL || !tmp->hasTile(subTile)) {
+			missing++;
+			continue;
+		}
+		TMPFile::TileHeader const& th = tmp->getTileHeader(subTile);
+		uint8_t* px = &rgba[(((e.x + e.y) - minV) * width + ((e.x - e.y) - minU)) * 4];
+		memcpy(px, th.radarLeftColour, 3);
+		px[3] = 255;
+		memcpy(px + 4, th.radarRightColour, 3);
+		px[7] = 255;
+	}
+	if(missing) {
+		EWARN("%u of %u cells have no template in this theater", missing, map.numEntries);
+	}
+}
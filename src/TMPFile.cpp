@@ -25,7 +25,11 @@
 uint32_t const TMPFile::ra2TileWidth = 60;
 uint32_t const TMPFile::ra2TileHeight = 30;
 
-TMPFile::TMPFile(std::string const& file) : tileHeader(NULL), tileData(NULL), currentTile(0) {
+/* If headersOnly is set only the tile headers are read, which is enough for
+ * anything using the radar colours, terrain types etc. but none of the pixel
+ * accessors may be used
+ */
+TMPFile::TMPFile(std::string const& file, bool hdrOnly) : tileHeader(NULL), tileData(NULL), currentTile(0), headersOnly(hdrOnly) {
 	FILE* f = fopen(file.c_str(), "rb");
 	if(f == NULL) {
 		throw EXCEPTION("Could not open \"%s\" (%s)", file.c_str(), strerror(errno));
@@ -56,10 +60,16 @@ TMPFile::TMPFile(std::string const& file) : tileHeader(NULL), tileData(NULL), cu
 	tileHeader = new TileHeader[header.tilesX * header.tilesY];
 	tileData = new TileData[header.tilesX * header.tilesY];
 
-	for(uint32_t i = 0; i != header.tilesX * header.tilesY; i++) {
-		if(header.offset[i]) {
-			readTile(i, fixed);
+	try {
+		for(uint32_t i = 0; i != header.tilesX * header.tilesY; i++) {
+			if(header.offset[i]) {
+				readTile(i, fixed);
+			}
 		}
+	} catch(...) {
+		delete[] tileHeader;
+		delete[] tileData;
+		throw;
 	}
 }
 
@@ -75,7 +85,7 @@ void TMPFile::readTile(uint32_t n, Utils::FixedRead& fixed) {
 	fixed.read(&tileHeader[n].y);
 	fixed.read(&tileHeader[n].extraOffset);
 	fixed.read(&tileHeader[n].zOffset);
-	fixed.read(&tileHeader[n].extraOffset);
+	fixed.read(&tileHeader[n].extraZOffset);
 	fixed.read(&tileHeader[n].extraX);
 	fixed.read(&tileHeader[n].extraY);
 	fixed.read(&tileHeader[n].extraW);
@@ -88,8 +98,11 @@ void TMPFile::readTile(uint32_t n, Utils::FixedRead& fixed) {
 	fixed.read(tileHeader[n].radarRightColour, 3);
 	fixed.read(tileHeader[n].pad, 3);
 
+	if(headersOnly) {
+		return;
+	}
 	if(tileHeader[n].hasExtra()) {
-		tileData[n].alloc(tileHeader[n].extraW * tileHeader[n].extraH);
+		tileData[n].alloc(tileHeader[n].extraW * tileHeader[n].extraH, tileHeader[n].hasExtraZ());
 	} else {
 		tileData[n].alloc();
 	}
@@ -97,6 +110,10 @@ void TMPFile::readTile(uint32_t n, Utils::FixedRead& fixed) {
 	readIsoToSqr(tileData[n].height, fixed);
 	if(tileHeader[n].hasExtra()) {
 		fixed.read(tileData[n].extra, tileHeader[n].extraW * tileHeader[n].extraH);
+		/* The extra Z data immediately follows the extra pixels */
+		if(tileHeader[n].hasExtraZ()) {
+			fixed.read(tileData[n].extraHeight, tileHeader[n].extraW * tileHeader[n].extraH);
+		}
 	}
 }
 
@@ -114,10 +131,35 @@ void TMPFile::readIsoToSqr(uint8_t* img, Utils::FixedRead& fixed) {
 	}
 }
 
-uint32_t TMPFile::numTiles() {
+uint32_t TMPFile::numTiles() const {
 	return header.tilesX * header.tilesY;
 }
 
+bool TMPFile::hasTile(uint32_t n) const {
+	return n < header.tilesX * header.tilesY && header.offset[n] != 0;
+}
+
+TMPFile::TileHeader const& TMPFile::getTileHeader(uint32_t n) const {
+	if(!hasTile(n)) {
+		throw EXCEPTION("Tile %u is empty or out of range [%u %u] tiles", n, header.tilesX, header.tilesY);
+	}
+	return tileHeader[n];
+}
+
+bool TMPFile::hasTileData() const {
+	return !headersOnly;
+}
+
+TMPFile::TileData const& TMPFile::getTileData(uint32_t n) const {
+	if(headersOnly) {
+		throw EXCEPTION("Only tile headers were loaded");
+	}
+	if(!hasTile(n)) {
+		throw EXCEPTION("Tile %u is empty or out of range [%u %u] tiles", n, header.tilesX, header.tilesY);
+	}
+	return tileData[n];
+}
+
 void TMPFile::setCurrentTile(unsigned int x, unsigned int y) {
 	setCurrentTile((y * header.tilesX) + x);
 }
@@ -130,6 +172,9 @@ void TMPFile::setCurrentTile(uint32_t n) {
 }
 
 uint8_t TMPFile::getPixel(unsigned int x, unsigned int y) {
+	if(headersOnly) {
+		throw EXCEPTION("Only tile headers were loaded");
+	}
 	if(x >= ra2TileWidth || y >= ra2TileHeight) {
 		throw EXCEPTION("Pixel (%u, %u) is out of range (tile size is [%u %u])",
 			x, y, ra2TileWidth, ra2TileHeight
@@ -142,6 +187,9 @@ uint8_t TMPFile::getPixel(unsigned int x, unsigned int y) {
 }
 
 uint8_t TMPFile::getExtraPixel(unsigned int x, unsigned int y) {
+	if(headersOnly) {
+		throw EXCEPTION("Only tile headers were loaded");
+	}
 	if(!tileHeader[currentTile].hasExtra()) {
 		throw EXCEPTION("Tile does not have extra data");
 	}
@@ -162,6 +210,9 @@ uint8_t TMPFile::getExtraPixel(unsigned int x, unsigned int y) {
 }
 
 uint8_t TMPFile::getHeight(unsigned int x, unsigned int y) {
+	if(headersOnly) {
+		throw EXCEPTION("Only tile headers were loaded");
+	}
 	if(x >= ra2TileWidth || y >= ra2TileHeight) {
 		throw EXCEPTION("Hexel (%u, %u) is out of range (tile size is [%u %u])",
 			x, y, ra2TileWidth, ra2TileHeight
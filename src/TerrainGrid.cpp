@@ -0,0 +1,237 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "TerrainGrid.h"
+#include "Exception.h"
+
+uint8_t const TerrainGrid::Clear = 0;
+uint8_t const TerrainGrid::Road = 1;
+uint8_t const TerrainGrid::Water = 2;
+uint8_t const TerrainGrid::Rock = 3;
+uint8_t const TerrainGrid::Wall = 4;
+uint8_t const TerrainGrid::Tiberium = 5;
+uint8_t const TerrainGrid::Beach = 6;
+uint8_t const TerrainGrid::Rough = 7;
+uint8_t const TerrainGrid::Ice = 8;
+uint8_t const TerrainGrid::Railroad = 9;
+uint8_t const TerrainGrid::Tunnel = 10;
+uint8_t const TerrainGrid::Weeds = 11;
+uint8_t const TerrainGrid::NoTile = 15;
+
+unsigned int const TerrainGrid::Present = 0;
+unsigned int const TerrainGrid::Land = 1;
+unsigned int const TerrainGrid::Naval = 2;
+unsigned int const TerrainGrid::Ramp = 3;
+unsigned int const TerrainGrid::numLayers = 4;
+
+namespace {
+	uint32_t findRoot(std::vector<uint32_t>& parent, uint32_t l) {
+		while(parent[l] != l) {
+			parent[l] = parent[parent[l]];
+			l = parent[l];
+		}
+		return l;
+	}
+
+	void unite(std::vector<uint32_t>& parent, uint32_t a, uint32_t b) {
+		a = findRoot(parent, a);
+		b = findRoot(parent, b);
+		if(a < b) {
+			parent[b] = a;
+		} else if(b < a) {
+			parent[a] = b;
+		}
+	}
+}
+
+/* Cells without a template (missing from the theater) are present but
+ * NoTile, which isn't passable.  Height differences between neighbouring
+ * cells are ignored, cliffs are Rock anyway.
+ */
+TerrainGrid::TerrainGrid(MapReader const& map, Theater const& theater) : minX(0), minY(0), width(0), height(0), rowWords(0) {
+	if(map.numEntries == 0) {
+		return;
+	}
+	int32_t maxX = map.entry[0].x, maxY = map.entry[0].y;
+	minX = maxX;
+	minY = maxY;
+	for(uint32_t i = 1; i != map.numEntries; i++) {
+		MapReader::Entry const& e = map.entry[i];
+		if(e.x < minX) minX = e.x;
+		if(e.x > maxX) maxX = e.x;
+		if(e.y < minY) minY = e.y;
+		if(e.y > maxY) maxY = e.y;
+	}
+	width = maxX - minX + 1;
+	height = maxY - minY + 1;
+	rowWords = (width + 63) / 64;
+	layers.assign(static_cast<size_t>(numLayers) * height * rowWords, 0);
+	landTypes.assign((static_cast<size_t>(width) * height + 1) / 2, (NoTile << 4) | NoTile);
+
+	uint32_t missing = 0;
+	for(uint32_t i = 0; i != map.numEntries; i++) {
+		MapReader::Entry const& e = map.entry[i];
+		uint32_t x = e.x - minX, y = e.y - minY;
+		uint16_t tile = e.tile == -1 ? 0 : static_cast<uint16_t>(e.tile);
+		uint8_t subTile = static_cast<uint8_t>(e.subTile);
+		TMPFile const* tmp = theater.getTile(tile);
+		set(Present, x, y);
+		if(tmp == NULL || !tmp->hasTile(subTile)) {
+			missing++;
+			continue;
+		}
+		TMPFile::TileHeader const& th = tmp->getTileHeader(subTile);
+		uint8_t land = landType(th.terrainType);
+		setLandType(x, y, land);
+		if(land == Water) {
+			set(Naval, x, y);
+		} else if(land != Rock && land != Wall) {
+			set(Land, x, y);
+		}
+		if(th.rampType != 0) {
+			set(Ramp, x, y);
+		}
+	}
+	if(missing) {
+		EWARN("%u of %u cells have no template in this theater", missing, map.numEntries);
+	}
+}
+
+void TerrainGrid::set(unsigned int layer, uint32_t x, uint32_t y) {
+	layerRow(layer, y)[x / 64] |= static_cast<uint64_t>(1) << (x % 64);
+}
+
+/* Even cells are in the low nibble */
+void TerrainGrid::setLandType(uint32_t x, uint32_t y, uint8_t land) {
+	size_t i = static_cast<size_t>(y) * width + x;
+	uint8_t& b = landTypes[i / 2];
+	if(i % 2) {
+		b = (b & 0x0F) | (land << 4);
+	} else {
+		b = (b & 0xF0) | land;
+	}
+}
+
+/* The game's mapping from the terrain type in a tile header */
+uint8_t TerrainGrid::landType(uint8_t terrainType) {
+	static uint8_t const table[16] = {
+		Clear, Ice, Ice, Ice, Ice, Tunnel, Railroad, Rock,
+		Rock, Water, Beach, Road, Road, Clear, Rough, Rock,
+	};
+	return table[terrainType & 0x0F];
+}
+
+void TerrainGrid::getBounds(int32_t& x, int32_t& y, uint32_t& w, uint32_t& h) const {
+	x = minX;
+	y = minY;
+	w = width;
+	h = height;
+}
+
+uint32_t TerrainGrid::getRowWords() const {
+	return rowWords;
+}
+
+bool TerrainGrid::test(unsigned int layer, int32_t x, int32_t y) const {
+	if(x < minX || y < minY || static_cast<uint32_t>(x - minX) >= width || static_cast<uint32_t>(y - minY) >= height) {
+		return false;
+	}
+	uint32_t cx = x - minX;
+	return (getLayerRow(layer, y - minY)[cx / 64] >> (cx % 64)) & 1;
+}
+
+uint8_t TerrainGrid::getLandType(int32_t x, int32_t y) const {
+	if(x < minX || y < minY || static_cast<uint32_t>(x - minX) >= width || static_cast<uint32_t>(y - minY) >= height) {
+		return NoTile;
+	}
+	size_t i = static_cast<size_t>(y - minY) * width + (x - minX);
+	return (i % 2) ? landTypes[i / 2] >> 4 : landTypes[i / 2] & 0x0F;
+}
+
+uint32_t TerrainGrid::countCells(unsigned int layer) const {
+	uint32_t n = 0;
+	uint64_t const* w = getLayerRow(layer, 0);
+	for(size_t i = 0; i != static_cast<size_t>(height) * rowWords; i++) {
+		n += __builtin_popcountll(w[i]);
+	}
+	return n;
+}
+
+/* Labels the 8-connected regions of a layer, numbered from 1 in the order
+ * their first cell is found scanning row by row.  labels is width * height
+ * with 0 for cells not in the layer; sizes[n - 1] is the size of region n.
+ * Returns the number of regions.
+ *
+ * Two passes: the first hands out provisional labels, walking only the set
+ * bits of each word, and merges them with a union-find; the second
+ * resolves them to the compact numbering.
+ */
+uint32_t TerrainGrid::labelRegions(unsigned int layer, std::vector<uint32_t>& labels, std::vector<uint32_t>& sizes) const {
+	labels.assign(static_cast<size_t>(width) * height, 0);
+	sizes.clear();
+	std::vector<uint32_t> parent(1, 0);
+	for(uint32_t y = 0; y != height; y++) {
+		uint64_t const* row = getLayerRow(layer, y);
+		uint32_t* cur = &labels[static_cast<size_t>(y) * width];
+		uint32_t const* prev = y != 0 ? cur - width : NULL;
+		for(uint32_t w = 0; w != rowWords; w++) {
+			uint64_t bits = row[w];
+			while(bits != 0) {
+				uint32_t x = w * 64 + __builtin_ctzll(bits);
+				bits &= bits - 1;
+				uint32_t l = x != 0 ? cur[x - 1] : 0;
+				if(prev != NULL) {
+					uint32_t first = x != 0 ? x - 1 : 0;
+					uint32_t last = x + 1 < width ? x + 1 : x;
+					for(uint32_t nx = first; nx <= last; nx++) {
+						if(prev[nx] == 0) {
+							continue;
+						}
+						if(l == 0) {
+							l = prev[nx];
+						} else if(prev[nx] != l) {
+							unite(parent, l, prev[nx]);
+						}
+					}
+				}
+				if(l == 0) {
+					l = parent.size();
+					parent.push_back(l);
+				}
+				cur[x] = l;
+			}
+		}
+	}
+	std::vector<uint32_t> compact(parent.size(), 0);
+	uint32_t n = 0;
+	for(size_t i = 0; i != labels.size(); i++) {
+		if(labels[i] == 0) {
+			continue;
+		}
+		uint32_t r = findRoot(parent, labels[i]);
+		if(compact[r] == 0) {
+			compact[r] = ++n;
+			sizes.push_back(0);
+		}
+		labels[i] = compact[r];
+		sizes[compact[r] - 1]++;
+	}
+	return n;
+}
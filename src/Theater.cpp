@@ -0,0 +1,94 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Theater.h"
+#include "INIFile.h"
+#include "Exception.h"
+#include <stdio.h>
+#include <ctype.h>
+#include <unistd.h>
+
+Theater::Theater(std::string const& iniFile, std::string const& dir, std::string const& ext, bool headersOnly) {
+	INIFile ini(iniFile);
+	char name[32];
+	/* The destructor won't run if this throws, so free what was loaded */
+	try {
+		for(unsigned int set = 0; ; set++) {
+			snprintf(name, sizeof(name), "TileSet%04u", set);
+			if(!ini.sectionExists(name)) {
+				break;
+			}
+			ini.setCurrentSection(name);
+			int tilesInSet;
+			if(!ini.keyExists("FileName") || !ini.getInt("TilesInSet", tilesInSet)) {
+				throw EXCEPTION("Section [%s] is missing FileName or a valid TilesInSet", name);
+			}
+			std::string fileName = ini.getKey("FileName");
+			for(int i = 1; i <= tilesInSet; i++) {
+				snprintf(name, sizeof(name), "%02u", i);
+				tiles.push_back(NULL);
+				tiles.back() = loadTemplate(dir, fileName + name + "." + ext, headersOnly);
+			}
+		}
+	} catch(...) {
+		for(TileVec::iterator it = tiles.begin(); it != tiles.end(); it++) {
+			delete *it;
+		}
+		throw;
+	}
+	EDEBUG("Loaded %lu tiles from \"%s\"", tiles.size(), iniFile.c_str());
+}
+
+Theater::~Theater() {
+	for(TileVec::iterator it = tiles.begin(); it != tiles.end(); it++) {
+		delete *it;
+	}
+}
+
+/* Template names in the theater INI are mixed case but the extracted files
+ * usually aren't, so fall back to the lower case name.  Missing templates
+ * are not fatal (plenty of maps don't use every tile set), they just don't
+ * get drawn.  headersOnly is passed on to TMPFile
+ */
+TMPFile* Theater::loadTemplate(std::string const& dir, std::string const& name, bool headersOnly) {
+	std::string path = dir + "/" + name;
+	if(access(path.c_str(), R_OK) != 0) {
+		std::string lower(name);
+		for(size_t i = 0; i != lower.length(); i++) {
+			lower[i] = tolower(lower[i]);
+		}
+		path = dir + "/" + lower;
+		if(access(path.c_str(), R_OK) != 0) {
+			EDEBUG("Template \"%s\" not found", name.c_str());
+			return NULL;
+		}
+	}
+	return new TMPFile(path, headersOnly);
+}
+
+uint32_t Theater::numTiles() const {
+	return tiles.size();
+}
+
+TMPFile const* Theater::getTile(uint32_t n) const {
+	if(n >= tiles.size()) {
+		return NULL;
+	}
+	return tiles[n];
+}
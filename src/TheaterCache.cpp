@@ -0,0 +1,74 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "TheaterCache.h"
+#include "Exception.h"
+
+namespace {
+	struct TheaterInfo {
+		char const* name;
+		char const* ini;
+		char const* ext;
+	};
+
+	TheaterInfo const theaterInfo[] = {
+		{ "TEMPERATE", "temperatmd.ini", "tem" },
+		{ "SNOW", "snowmd.ini", "sno" },
+		{ "URBAN", "urbanmd.ini", "urb" },
+		{ "NEWURBAN", "urbannmd.ini", "ubn" },
+		{ "DESERT", "desertmd.ini", "des" },
+		{ "LUNAR", "lunarmd.ini", "lun" },
+	};
+}
+
+TheaterCache::TheaterCache(std::string const& dir) : dataDir(dir) {
+	pthread_mutex_init(&lock, NULL);
+}
+
+TheaterCache::~TheaterCache() {
+	for(TheaterMap::iterator it = theaters.begin(); it != theaters.end(); it++) {
+		delete it->second;
+	}
+	pthread_mutex_destroy(&lock);
+}
+
+Theater const& TheaterCache::get(std::string const& name) {
+	pthread_mutex_lock(&lock);
+	TheaterMap::iterator it = theaters.find(name);
+	if(it == theaters.end()) {
+		Theater* t = NULL;
+		for(unsigned int i = 0; i != sizeof(theaterInfo) / sizeof(theaterInfo[0]); i++) {
+			if(name == theaterInfo[i].name) {
+				try {
+					t = new Theater(dataDir + "/" + theaterInfo[i].ini, dataDir, theaterInfo[i].ext, true);
+				} catch(...) {
+					pthread_mutex_unlock(&lock);
+					throw;
+				}
+			}
+		}
+		it = theaters.insert(std::make_pair(name, t)).first;
+	}
+	pthread_mutex_unlock(&lock);
+	if(it->second == NULL) {
+		throw EXCEPTION("Unknown theater \"%s\"", name.c_str());
+	}
+	return *it->second;
+}
@@ -0,0 +1,150 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "TileMips.h"
+#include "Exception.h"
+#include <algorithm>
+
+unsigned int const TileMips::numLevels = 3;
+
+/* Cells sit on a lattice of half a tile across (30 pixels) and half a tile
+ * down (15 pixels), so at 1/scale a cell can start at any of scale / 2 even
+ * sub-pixel phases across and any of scale down.  Every template is shrunk
+ * once per phase, so each thumbnail pixel is made from exactly the full
+ * size pixels under it and neighbouring cells meet without seams
+ */
+TileMips::TileMips(Theater const& theater, Palette const& pal) : levels(numLevels) {
+	uint8_t rgb[256][3];
+	for(unsigned int i = 0; i != 256; i++) {
+		pal.getRGB(i, rgb[i][0], rgb[i][1], rgb[i][2]);
+	}
+	firstEntry.resize(theater.numTiles(), 0);
+	numEntries.resize(theater.numTiles(), 0);
+	uint32_t subTiles = 0;
+	for(uint32_t t = 0; t != theater.numTiles(); t++) {
+		TMPFile const* tmp = theater.getTile(t);
+		firstEntry[t] = subTiles;
+		if(tmp == NULL) {
+			continue;
+		}
+		numEntries[t] = tmp->numTiles();
+		subTiles += tmp->numTiles();
+		for(uint32_t s = 0; s != tmp->numTiles(); s++) {
+			for(unsigned int l = 0; l != numLevels; l++) {
+				int32_t scale = 2 << l;
+				for(int32_t py = 0; py != scale; py++) {
+					for(int32_t px = 0; px != scale; px += 2) {
+						Entry e;
+						e.tile.w = e.extra.w = 0;
+						if(tmp->hasTile(s)) {
+							TMPFile::TileHeader const& th = tmp->getTileHeader(s);
+							TMPFile::TileData const& td = tmp->getTileData(s);
+							e.tile.x = e.tile.y = 0;
+							shrink(levels[l], e.tile, l + 1, px, py, td.tile, TMPFile::ra2TileWidth, TMPFile::ra2TileHeight, rgb);
+							if(th.hasExtra()) {
+								e.extra.x = th.extraX - th.x;
+								e.extra.y = th.extraY - th.y;
+								shrink(levels[l], e.extra, l + 1, (px + e.extra.x) & (scale - 1), (py + e.extra.y) & (scale - 1),
+									td.extra, th.extraW, th.extraH, rgb);
+							}
+						}
+						levels[l].entries.push_back(e);
+					}
+				}
+			}
+		}
+	}
+	EDEBUG("Built %u mip levels for %u tiles (%lu bytes)", numLevels, theater.numTiles(), getMemoryUsage());
+}
+
+/* Box filters an indexed image down by 2^shift into the level's atlas, with
+ * the image starting (px, py) pixels into the first output pixel
+ */
+void TileMips::shrink(Level& level, Image& img, unsigned int shift, int32_t px, int32_t py,
+		uint8_t const* src, uint32_t w, uint32_t h, uint8_t const (*rgb)[3]) {
+	int32_t scale = 1 << shift;
+	img.w = (px + w + scale - 1) >> shift;
+	img.h = (py + h + scale - 1) >> shift;
+	img.offset = level.atlas.size();
+	level.atlas.resize(img.offset + img.w * img.h * 4);
+	uint8_t* out = &level.atlas[img.offset];
+	for(int32_t oy = 0; oy != static_cast<int32_t>(img.h); oy++) {
+		int32_t sy = std::max(0, (oy << shift) - py), ey = std::min(static_cast<int32_t>(h), ((oy + 1) << shift) - py);
+		for(int32_t ox = 0; ox != static_cast<int32_t>(img.w); ox++) {
+			int32_t sx = std::max(0, (ox << shift) - px), ex = std::min(static_cast<int32_t>(w), ((ox + 1) << shift) - px);
+			uint32_t sum[3] = { 0, 0, 0 };
+			uint32_t opaque = 0;
+			for(int32_t y = sy; y < ey; y++) {
+				for(int32_t x = sx; x < ex; x++) {
+					uint8_t p = src[y * w + x];
+					if(p) {
+						sum[0] += rgb[p][0];
+						sum[1] += rgb[p][1];
+						sum[2] += rgb[p][2];
+						opaque++;
+					}
+				}
+			}
+			if(opaque) {
+				out[0] = sum[0] / opaque;
+				out[1] = sum[1] / opaque;
+				out[2] = sum[2] / opaque;
+				out[3] = (opaque * 255) / (scale * scale);
+			} else {
+				out[0] = out[1] = out[2] = out[3] = 0;
+			}
+			out += 4;
+		}
+	}
+}
+
+/* Level 1 is half size, 2 quarter size, 3 eighth size.  (x, y) is where
+ * the cell starts in full size pixels from the thumbnail's origin, which
+ * picks the phase the images were shrunk at.  Returns NULL for tiles which
+ * don't exist in the theater
+ */
+TileMips::Entry const* TileMips::getEntry(uint32_t tile, uint32_t subTile, unsigned int level, int32_t x, int32_t y) const {
+	if(level < 1 || level > numLevels) {
+		throw EXCEPTION("Mip level %u is out of range [1 %u]", level, numLevels);
+	}
+	if(tile >= firstEntry.size() || subTile >= numEntries[tile]) {
+		return NULL;
+	}
+	int32_t scale = 1 << level;
+	int32_t px = x & (scale - 1), py = y & (scale - 1);
+	if(px & 1) {
+		throw EXCEPTION("Cell at (%i, %i) is not on the tile lattice", x, y);
+	}
+	uint32_t phases = scale * scale / 2;
+	Entry const* e = &levels[level - 1].entries[(firstEntry[tile] + subTile) * phases + py * (scale / 2) + px / 2];
+	return e->tile.w ? e : NULL;
+}
+
+uint8_t const* TileMips::getPixels(Image const& img, unsigned int level) const {
+	return &levels[level - 1].atlas[img.offset];
+}
+
+size_t TileMips::getMemoryUsage() const {
+	size_t sz = 0;
+	for(std::vector<Level>::const_iterator it = levels.begin(); it != levels.end(); it++) {
+		sz += it->atlas.size() + it->entries.size() * sizeof(Entry);
+	}
+	return sz;
+}
@@ -20,6 +20,8 @@
 #include "VoxelRenderer.h"
 #include "Exception.h"
 #include <SDL/SDL_opengl.h>
+#include <math.h>
+#include <string.h>
 
 float VoxelRenderer::lightPos[4] = { 5, 0, 10, 0, };
 float VoxelRenderer::lightSpec[4] = { 1, 0.5, 0, 0, };
@@ -37,6 +39,17 @@ void VoxelRenderer::setupLighting(int light) {
 
 void VoxelRenderer::setHVA(HVAFile* h) {
 	hva = h;
+	bindSections();
+}
+
+void VoxelRenderer::bindSections() {
+	limbSections.clear();
+	if(hva) {
+		for(uint32_t i = 0; i != vxl.getNumLimbs(); i++) {
+			vxl.setCurrentLimb(i);
+			limbSections.push_back(hva->findSection(vxl.limbName()));
+		}
+	}
 }
 
 void printMatrix(float* m) {
@@ -53,19 +66,57 @@ void printMatrix(float* m) {
 }
 
 void VoxelRenderer::render(bool coloured, bool normals) {
-	if(hva && frame >= hva->numFrames()) {
-		frame = 0;
+	float const* matrices = NULL;
+	if(hva && hva->numFrames() != 0) {
+		if(frame >= hva->numFrames()) {
+			frame = fmodf(frame, static_cast<float>(hva->numFrames()));
+		}
+		/* Whole frames use the file's matrices directly, anything in between
+		 * samples all the sections in one go
+		 */
+		if(frame >= 0 && floorf(frame) == frame) {
+			matrices = hva->getGLMatrices(static_cast<uint32_t>(frame));
+		} else {
+			sampled.resize(hva->numSections() * 16);
+			hva->sampleAll(frame, &sampled[0]);
+			matrices = &sampled[0];
+		}
 	}
 	for(uint32_t i = 0; i != vxl.getNumLimbs(); i++) {
 		vxl.setCurrentLimb(i);
-		if(hva) {
-			hva->setCurrentSection(vxl.limbName());
+		renderSection(matrices != NULL ? matrices + limbSections[i] * 16 : NULL, coloured, normals);
+	}
+}
+
+void VoxelRenderer::render(BakedModel const& baked, bool coloured, bool normals) {
+	uint32_t f = baked.getFrame(frame);
+	for(uint32_t i = 0; i != baked.numLimbs(); i++) {
+		vxl.setCurrentLimb(i);
+		size_t n;
+		BakedModel::Voxel const* vx = baked.getVoxels(i, n);
+		float const* scale = baked.getSectionScale(i);
+		glPushMatrix();
+		glMultMatrixf(baked.getTransform(f, i));
+		glBegin(GL_QUADS);
+		for(size_t j = 0; j != n; j++) {
+			if(coloured) {
+				float colour[3];
+				vxl.getPalette().getRGB(vx[j].colour, colour[0], colour[1], colour[2]);
+				glColor3fv(colour);
+			}
+			if(normals) {
+				float normal[3];
+				vxl.getXYZNormal(vx[j].normal, normal[0], normal[1], normal[2]);
+				glNormal3fv(normal);
+			}
+			renderVoxel((float)vx[j].x * scale[0], (float)vx[j].y * scale[1], (float)vx[j].z * scale[2], (1 - pitch) / 2);
 		}
-		renderSection(coloured, normals);
+		glEnd();
+		glPopMatrix();
 	}
 }
 
-void VoxelRenderer::renderSection(bool coloured, bool normals) {
+void VoxelRenderer::renderSection(float const* hvaMatrix, bool coloured, bool normals) {
 	glPushMatrix();
 	uint8_t xs, ys, zs;
 	float min[3], max[3];
@@ -84,8 +135,8 @@ void VoxelRenderer::renderSection(bool coloured, bool normals) {
 	sectionScale[2] = max[2] / (float)zs;
 
 	/* Load transformation matrix */
-	if(hva) {
-		hva->loadGLMatrix(frame, transform);
+	if(hvaMatrix != NULL) {
+		memcpy(transform, hvaMatrix, sizeof(transform));
 		/* The HVA transformation matrices have to be scaled */
 		transform[12] *= vxl.getScale() * sectionScale[0];
 		transform[13] *= vxl.getScale() * sectionScale[1];
@@ -0,0 +1,106 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "WorkQueue.h"
+#include "Utils.h"
+#include <unistd.h>
+#include <vector>
+
+WorkQueue::WorkQueue(Task& t, size_t n) :
+		task(t), numItems(n), nextItem(0), failedItem(n),
+		failure(__FILE__, __LINE__, "No error") {
+	pthread_mutex_init(&lock, NULL);
+}
+
+WorkQueue::~WorkQueue() {
+	pthread_mutex_destroy(&lock);
+}
+
+unsigned int WorkQueue::numThreads() {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	if(n < 1) {
+		return 1;
+	}
+	return static_cast<unsigned int>(n);
+}
+
+bool WorkQueue::next(size_t& item) {
+	pthread_mutex_lock(&lock);
+	/* Items after a failure can never be reported, so don't bother with them */
+	bool more = nextItem < numItems && nextItem < failedItem;
+	if(more) {
+		item = nextItem++;
+	}
+	pthread_mutex_unlock(&lock);
+	return more;
+}
+
+void WorkQueue::fail(size_t item, Exception const& e) {
+	pthread_mutex_lock(&lock);
+	if(item < failedItem) {
+		failedItem = item;
+		failure = e;
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+void* WorkQueue::worker(void* arg) {
+	WorkQueue* q = static_cast<WorkQueue*>(arg);
+	size_t item;
+	while(q->next(item)) {
+		try {
+			q->task.run(item);
+		} catch(Exception& e) {
+			q->fail(item, e);
+		} catch(std::exception& e) {
+			q->fail(item, EXCEPTION("Work item %lu failed (%s)", item, e.what()));
+		}
+	}
+	return NULL;
+}
+
+void WorkQueue::run(Task& task, size_t n, unsigned int threads) {
+	if(threads == 0) {
+		threads = numThreads();
+	}
+	if(threads > n) {
+		threads = n;
+	}
+	WorkQueue q(task, n);
+	if(threads <= 1) {
+		worker(&q);
+	} else {
+		std::vector<pthread_t> tids(threads - 1);
+		size_t started = 0;
+		for(; started != tids.size(); started++) {
+			if(pthread_create(&tids[started], NULL, &worker, &q) != 0) {
+				EWARN("Could only start %lu of %u threads", started + 1, threads);
+				break;
+			}
+		}
+		/* The calling thread does its share of the work too */
+		worker(&q);
+		for(size_t i = 0; i != started; i++) {
+			pthread_join(tids[i], NULL);
+		}
+	}
+	if(q.failedItem != n) {
+		throw q.failure;
+	}
+}
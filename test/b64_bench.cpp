@@ -0,0 +1,186 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "Base64.h"
+#include "Exception.h"
+#include "Utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+/* Checks every Base64 decoder and encoder the CPU supports against the
+ * scalar ones, then times them.  Inputs cover every length up to a few
+ * vector blocks, padding and invalid characters at every position so the
+ * fallback paths get used
+ */
+
+namespace {
+	char const* implNames[] = {"scalar", "ssse3", "avx2"};
+	int const numImpls = 3;
+	uint8_t const alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	size_t encode(uint8_t const* in, size_t len, uint8_t* out) {
+		size_t o = 0;
+		for(size_t i = 0; i < len; i += 3) {
+			uint32_t accum = in[i] << 16;
+			if(i + 1 < len) {
+				accum |= in[i + 1] << 8;
+			}
+			if(i + 2 < len) {
+				accum |= in[i + 2];
+			}
+			out[o++] = alphabet[(accum >> 18) & 0x3F];
+			out[o++] = alphabet[(accum >> 12) & 0x3F];
+			out[o++] = i + 1 < len ? alphabet[(accum >> 6) & 0x3F] : '=';
+			out[o++] = i + 2 < len ? alphabet[accum & 0x3F] : '=';
+		}
+		return o;
+	}
+
+	double now() {
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		return tv.tv_sec + tv.tv_usec / 1000000.0;
+	}
+
+	/* Decodes with the given implementation, returning the length or -1 and
+	 * the exception message if it threw
+	 */
+	long tryDecode(int impl, uint8_t const* in, size_t len, uint8_t* out, std::string& err) {
+		Base64::setImplementation(impl);
+		try {
+			return Base64::decode(in, out, len);
+		} catch(Exception& e) {
+			err = e.what();
+			return -1;
+		}
+	}
+
+	bool compare(int impl, uint8_t const* in, size_t len) {
+		Utils::ScopedArray<uint8_t> ref(new uint8_t[len / 4 * 3 + 1]);
+		Utils::ScopedArray<uint8_t> got(new uint8_t[len / 4 * 3 + 1]);
+		std::string refErr, gotErr;
+		long refLen = tryDecode(Base64::Scalar, in, len, ref.ptr, refErr);
+		long gotLen = tryDecode(impl, in, len, got.ptr, gotErr);
+		if(refLen != gotLen || refErr != gotErr || (refLen > 0 && memcmp(ref.ptr, got.ptr, refLen) != 0)) {
+			fprintf(stderr, "%s differs from scalar on %lu byte input\n", implNames[impl], len);
+			return false;
+		}
+		/* In place decoding must give the same result */
+		if(refLen > 0) {
+			Utils::ScopedArray<uint8_t> inout(new uint8_t[len]);
+			memcpy(inout.ptr, in, len);
+			Base64::setImplementation(impl);
+			Base64::decode(inout.ptr, len);
+			if(memcmp(inout.ptr, ref.ptr, refLen) != 0) {
+				fprintf(stderr, "%s in place decode differs on %lu byte input\n", implNames[impl], len);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool check(int impl) {
+		uint8_t raw[256];
+		uint8_t b64[512];
+		uint8_t enc[512];
+		for(size_t i = 0; i != sizeof(raw); i++) {
+			raw[i] = rand();
+		}
+		for(size_t rawLen = 0; rawLen != 150; rawLen++) {
+			size_t len = encode(raw, rawLen, b64);
+			Base64::setImplementation(impl);
+			if(Base64::encode(raw, rawLen, enc) != len || Base64::encodedSize(rawLen) != len || memcmp(enc, b64, len) != 0) {
+				fprintf(stderr, "%s encoder is wrong for %lu bytes\n", implNames[impl], rawLen);
+				return false;
+			}
+			if(!compare(impl, b64, len)) {
+				return false;
+			}
+			for(size_t bad = 0; bad < len; bad++) {
+				uint8_t saved = b64[bad];
+				b64[bad] = "=*\n\x80"[bad % 4];
+				if(!compare(impl, b64, len)) {
+					return false;
+				}
+				b64[bad] = saved;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv) {
+	size_t size = 16 << 20;
+	unsigned int iterations = 10;
+	if(argc > 1) {
+		size = atol(argv[1]);
+	}
+	if(argc > 2) {
+		iterations = atoi(argv[2]);
+	}
+	int best = Base64::getImplementation();
+	for(int impl = 0; impl != numImpls; impl++) {
+		if(!Base64::isSupported(impl)) {
+			printf("%-8s not supported\n", implNames[impl]);
+			continue;
+		}
+		if(!check(impl)) {
+			return 1;
+		}
+	}
+
+	Utils::ScopedArray<uint8_t> raw(new uint8_t[size]);
+	for(size_t i = 0; i != size; i++) {
+		raw.ptr[i] = rand();
+	}
+	Utils::ScopedArray<uint8_t> b64(new uint8_t[(size + 2) / 3 * 4]);
+	size_t len = encode(raw.ptr, size, b64.ptr);
+	Utils::ScopedArray<uint8_t> out(new uint8_t[len / 4 * 3]);
+	for(int impl = 0; impl != numImpls; impl++) {
+		if(!Base64::isSupported(impl)) {
+			continue;
+		}
+		Base64::setImplementation(impl);
+		double start = now();
+		for(unsigned int i = 0; i != iterations; i++) {
+			if(Base64::decode(b64.ptr, out.ptr, len) != size) {
+				fprintf(stderr, "%s decoded the wrong length\n", implNames[impl]);
+				return 1;
+			}
+		}
+		double t = now() - start;
+		if(memcmp(out.ptr, raw.ptr, size) != 0) {
+			fprintf(stderr, "%s did not round trip\n", implNames[impl]);
+			return 1;
+		}
+		start = now();
+		for(unsigned int i = 0; i != iterations; i++) {
+			Base64::encode(raw.ptr, size, b64.ptr);
+		}
+		double te = now() - start;
+		printf("%-8s decode %8.1f MB/s, encode %8.1f MB/s%s\n", implNames[impl],
+			(len * (double)iterations) / t / (1 << 20),
+			(len * (double)iterations) / te / (1 << 20),
+			impl == best ? " (default)" : "");
+	}
+	return 0;
+}
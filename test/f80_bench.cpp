@@ -0,0 +1,261 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "MapReader.h"
+#include "Exception.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <vector>
+
+/* Differential test and benchmark of MapReader::decode80 against
+ * decode80Reference.  Streams are made up of random but valid commands;
+ * the two decoders must agree exactly on those.  The streams are then
+ * corrupted, where decode80 is allowed to reject more than the reference
+ * (it is stricter about truncated commands and unwritten data) but anything
+ * it does accept must decode the same.
+ *
+ * MapReader::encode80 is also checked to stay inside maxEncoded80Size and to
+ * round trip, including on data built to make it expand
+ */
+
+namespace {
+	double now() {
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		return tv.tv_sec + tv.tv_usec / 1000000.0;
+	}
+
+	size_t pick(size_t lo, size_t hi) {
+		return lo + rand() % (hi - lo + 1);
+	}
+
+	void put16(std::vector<uint8_t>& v, size_t x) {
+		v.push_back(x & 0xFF);
+		v.push_back(x >> 8);
+	}
+
+	/* Builds a stream decoding to outLen bytes, fillWeight out of 10 commands
+	 * are fills which makes it look more like overlay data
+	 */
+	void generate(std::vector<uint8_t>& in, size_t outLen, unsigned int fillWeight) {
+		in.clear();
+		size_t op = 0;
+		while(op != outLen) {
+			size_t left = outLen - op;
+			unsigned int kind = rand() % 10;
+			if(kind < fillWeight || op == 0) {
+				size_t count = pick(1, left < 600 ? left : 600);
+				in.push_back(0xFE);
+				put16(in, count);
+				in.push_back(rand() % 4 ? 0xFF : rand());
+				op += count;
+				continue;
+			}
+			kind = rand() % 4;
+			if(kind == 0) {
+				size_t count = pick(1, left < 63 ? left : 63);
+				in.push_back(0x80 | count);
+				for(size_t i = 0; i != count; i++) {
+					in.push_back(rand());
+				}
+				op += count;
+			} else if(kind == 1 && left >= 3) {
+				size_t count = pick(3, left < 10 ? left : 10);
+				size_t rel = pick(1, op < 4095 ? op : 4095);
+				in.push_back(((count - 3) << 4) | (rel >> 8));
+				in.push_back(rel & 0xFF);
+				op += count;
+			} else if(kind == 2 && left >= 3) {
+				size_t count = pick(3, left < 64 ? left : 64);
+				size_t pos = pick(0, op - 1);
+				if(pos + count >= outLen) {
+					continue;
+				}
+				in.push_back(0xC0 | (count - 3));
+				put16(in, pos);
+				op += count;
+			} else if(kind == 3) {
+				size_t count = pick(1, left < 2000 ? left : 2000);
+				size_t pos = pick(0, op - 1);
+				if(pos + count >= outLen) {
+					continue;
+				}
+				in.push_back(0xFF);
+				put16(in, count);
+				put16(in, pos);
+				op += count;
+			}
+		}
+		in.push_back(0x80);
+	}
+
+	/* Returns the decoded length, or -1 if it threw */
+	long tryDecode(bool reference, std::vector<uint8_t> const& in, std::vector<uint8_t>& out) {
+		try {
+			if(reference) {
+				return MapReader::decode80Reference(&in[0], &out[0], in.size() - 8, out.size());
+			}
+			return MapReader::decode80(&in[0], &out[0], in.size() - 8, out.size());
+		} catch(Exception& e) {
+			return -1;
+		}
+	}
+
+	bool check(unsigned int iterations) {
+		std::vector<uint8_t> in, ref(65535), got(65535);
+		size_t rejected = 0;
+		for(unsigned int it = 0; it != iterations; it++) {
+			size_t outLen = pick(1, 65535);
+			ref.assign(outLen, 0);
+			got.assign(outLen, 0);
+			generate(in, outLen, rand() % 10);
+			/* The reference decoder can read a few bytes past the end of
+			 * bad input, so give it some padding
+			 */
+			in.insert(in.end(), 8, 0);
+			long refLen = tryDecode(true, in, ref);
+			long gotLen = tryDecode(false, in, got);
+			if(refLen != static_cast<long>(outLen) || gotLen != refLen || ref != got) {
+				fprintf(stderr, "Iteration %u: decoders differ on a valid stream (%li, %li, %lu)\n", it, refLen, gotLen, outLen);
+				return false;
+			}
+			for(unsigned int c = 0; c != 8; c++) {
+				std::vector<uint8_t> bad(in);
+				for(unsigned int n = pick(1, 4); n != 0; n--) {
+					bad[rand() % (bad.size() - 8)] = rand();
+				}
+				ref.assign(outLen, 0);
+				got.assign(outLen, 0);
+				gotLen = tryDecode(false, bad, got);
+				if(gotLen == -1) {
+					rejected++;
+					continue;
+				}
+				refLen = tryDecode(true, bad, ref);
+				if(refLen != gotLen || memcmp(&ref[0], &got[0], gotLen) != 0) {
+					fprintf(stderr, "Iteration %u: decoders differ on a corrupted stream (%li, %li)\n", it, refLen, gotLen);
+					return false;
+				}
+			}
+		}
+		printf("%u valid streams, %u corrupted (%lu rejected) all agree\n", iterations, iterations * 8, rejected);
+		return true;
+	}
+
+	/* Short matches far back, each followed by a byte that breaks the match,
+	 * is the worst case for an encoder that takes every 3 byte match
+	 */
+	void generateFarMatches(std::vector<uint8_t>& data, size_t len) {
+		data.resize(len);
+		size_t const prefix = len < 8192 ? len : 8192;
+		for(size_t i = 0; i != prefix; i++) {
+			data[i] = rand();
+		}
+		for(size_t i = prefix; i < len; i += 4) {
+			size_t src = pick(0, prefix - 4);
+			for(size_t j = 0; j != 3 && i + j < len; j++) {
+				data[i + j] = data[src + j];
+			}
+			if(i + 3 < len) {
+				data[i + 3] = rand();
+			}
+		}
+	}
+
+	bool checkEncoder(unsigned int iterations) {
+		std::vector<uint8_t> data, packed, unpacked;
+		size_t worst = 0, worstLen = 0;
+		for(unsigned int it = 0; it != iterations; it++) {
+			size_t len = pick(1, 65535);
+			if(it % 2 == 0) {
+				generateFarMatches(data, len);
+			} else {
+				std::vector<uint8_t> stream;
+				generate(stream, len, rand() % 10);
+				data.resize(len);
+				MapReader::decode80(&stream[0], &data[0], stream.size(), len);
+			}
+			/* Exactly the promised room, so an overrun shows up under ASan */
+			packed.resize(MapReader::maxEncoded80Size(len));
+			unpacked.assign(len, 0);
+			size_t packedLen = MapReader::encode80(&data[0], &packed[0], len, packed.size());
+			size_t got = MapReader::decode80(&packed[0], &unpacked[0], packedLen, len);
+			if(got != len || unpacked != data) {
+				fprintf(stderr, "Iteration %u: %lu bytes do not survive encode80\n", it, len);
+				return false;
+			}
+			if(worstLen == 0 || packedLen * worstLen > worst * len) {
+				worst = packedLen;
+				worstLen = len;
+			}
+		}
+		printf("%u sections encoded, worst %lu bytes to %lu\n", iterations, worstLen, worst);
+		return true;
+	}
+
+	double bench(bool reference, std::vector<std::vector<uint8_t> > const& streams, size_t sectionLen, unsigned int iterations) {
+		std::vector<uint8_t> out(sectionLen);
+		double start = now();
+		for(unsigned int i = 0; i != iterations; i++) {
+			for(size_t s = 0; s != streams.size(); s++) {
+				size_t len = reference ?
+					MapReader::decode80Reference(&streams[s][0], &out[0], streams[s].size(), out.size()) :
+					MapReader::decode80(&streams[s][0], &out[0], streams[s].size(), out.size());
+				if(len != sectionLen) {
+					throw EXCEPTION("Decoded %lu bytes, expected %lu", len, sectionLen);
+				}
+			}
+		}
+		return (now() - start) / iterations;
+	}
+}
+
+int main(int argc, char** argv) {
+	unsigned int checks = 2000;
+	unsigned int iterations = 20;
+	if(argc > 1) {
+		checks = atoi(argv[1]);
+	}
+	if(argc > 2) {
+		iterations = atoi(argv[2]);
+	}
+	srand(1);
+	if(!check(checks) || !checkEncoder(checks / 10 + 1)) {
+		return 1;
+	}
+
+	/* An OverlayPack's worth (512x512) of 8K sections */
+	size_t const sectionLen = 8192;
+	std::vector<std::vector<uint8_t> > streams(512 * 512 / sectionLen);
+	size_t packed = 0;
+	for(size_t s = 0; s != streams.size(); s++) {
+		generate(streams[s], sectionLen, 6);
+		packed += streams[s].size();
+	}
+	double refTime = bench(true, streams, sectionLen, iterations);
+	double fastTime = bench(false, streams, sectionLen, iterations);
+	double mb = (512.0 * 512.0) / (1 << 20);
+	printf("%lu bytes packed into %lu\n", static_cast<size_t>(512 * 512), packed);
+	printf("decode80Reference %8.1f MB/s\n", mb / refTime);
+	printf("decode80          %8.1f MB/s\n", mb / fastTime);
+	return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "HVAFile.h"
+#include "Exception.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <vector>
+
+/* Checks HVAFile::sample reproduces the keyframes at whole frame times and
+ * that sampleAll agrees with it in between, then times both.  Given a time,
+ * prints every section's interpolated matrix instead
+ */
+
+namespace {
+	double now() {
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+	}
+
+	float maxDiff(float const* a, float const* b) {
+		float d = 0;
+		for(int i = 0; i != 16; i++) {
+			d = fmaxf(d, fabsf(a[i] - b[i]));
+		}
+		return d;
+	}
+
+	void printMatrix(float const* m) {
+		for(int r = 0; r != 3; r++) {
+			printf("  |% 8.04f  % 8.04f  % 8.04f  % 8.04f|\n", m[r], m[r + 4], m[r + 8], m[r + 12]);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		fprintf(stderr, "Usage: (bin) <hva-file> [<time>]\n");
+		return 1;
+	}
+	HVAFile hva(argv[1]);
+	uint32_t sections = hva.numSections();
+	uint32_t frames = hva.numFrames();
+	std::vector<float> all(sections * 16);
+	float m[16], key[16];
+
+	if(argc > 2) {
+		hva.sampleAll(static_cast<float>(atof(argv[2])), &all[0]);
+		for(uint32_t j = 0; j != sections; j++) {
+			printf("Section %u\n", j);
+			printMatrix(&all[j * 16]);
+		}
+		return 0;
+	}
+
+	float keyErr = 0, batchErr = 0;
+	for(uint32_t j = 0; j != sections; j++) {
+		hva.setCurrentSection(hva.getSectionName(j));
+		for(uint32_t i = 0; i != frames; i++) {
+			hva.loadGLMatrix(i, key);
+			hva.sample(j, static_cast<float>(i), m);
+			keyErr = fmaxf(keyErr, maxDiff(key, m));
+		}
+	}
+	uint32_t steps = frames * 16;
+	for(uint32_t s = 0; s != steps; s++) {
+		float time = static_cast<float>(s) / 16 + 1.0f / 32;
+		hva.sampleAll(time, &all[0]);
+		for(uint32_t j = 0; j != sections; j++) {
+			hva.sample(j, time, m);
+			batchErr = fmaxf(batchErr, maxDiff(&all[j * 16], m));
+		}
+	}
+	printf("%u sections, %u frames: keyframe error %g, batch error %g\n", sections, frames, keyErr, batchErr);
+
+	unsigned int const reps = 200000 / (sections + 1) + 1;
+	volatile float sink = 0;
+	double start = now();
+	for(unsigned int r = 0; r != reps; r++) {
+		float time = static_cast<float>(r) * 0.37f;
+		for(uint32_t j = 0; j != sections; j++) {
+			hva.sample(j, time, m);
+			sink += m[12];
+		}
+	}
+	double scalar = now() - start;
+	start = now();
+	for(unsigned int r = 0; r != reps; r++) {
+		hva.sampleAll(static_cast<float>(r) * 0.37f, &all[0]);
+		sink += all[12];
+	}
+	double batch = now() - start;
+	printf("sample: %.1f ns/section, sampleAll: %.1f ns/section\n",
+		scalar * 1e6 / (reps * sections), batch * 1e6 / (reps * sections));
+	return (keyErr < 1e-4f && batchErr < 1e-4f) ? 0 : 1;
+}
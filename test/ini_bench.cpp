@@ -0,0 +1,116 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "INIFile.h"
+#include "MappedINIFile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <iterator>
+
+/* Parses an INI file with INIFile (eagerly and lazily) and MappedINIFile,
+ * checks they agree on every section and key and reports how long each took
+ */
+
+namespace {
+	double now() {
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		return tv.tv_sec + tv.tv_usec / 1000000.0;
+	}
+}
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		fprintf(stderr, "Usage: (bin) <ini-file> [iterations]\n");
+		return 1;
+	}
+	unsigned int iterations = 10;
+	if(argc > 2) {
+		iterations = atoi(argv[2]);
+	}
+
+	double start = now();
+	for(unsigned int i = 1; i != iterations; i++) {
+		INIFile ini(argv[1]);
+	}
+	INIFile ini(argv[1]);
+	double iniTime = (now() - start) / iterations;
+
+	start = now();
+	for(unsigned int i = 1; i != iterations; i++) {
+		INIFile lazy(argv[1], true);
+	}
+	INIFile lazy(argv[1], true);
+	double lazyTime = (now() - start) / iterations;
+
+	start = now();
+	for(unsigned int i = 1; i != iterations; i++) {
+		MappedINIFile mapped(argv[1]);
+	}
+	MappedINIFile mapped(argv[1]);
+	double mappedTime = (now() - start) / iterations;
+
+	size_t numSections = 0, numKeys = 0, bad = 0;
+	for(INIFile::section_iterator it = ini.sectionsBegin(); it != ini.sectionsEnd(); it++) {
+		numSections++;
+		if(!mapped.sectionExists(it->first)) {
+			fprintf(stderr, "Section [%s] missing\n", it->first.c_str());
+			bad++;
+			continue;
+		}
+		mapped.setCurrentSection(it->first);
+		size_t sectionKeys = 0;
+		for(INIFile::key_iterator jt = it->second.begin(); jt != it->second.end(); jt++) {
+			MappedINIFile::StringRef value;
+			numKeys++;
+			sectionKeys++;
+			if(!mapped.findKey(jt->first, value) || value.toString() != jt->second.str) {
+				fprintf(stderr, "[%s] %s differs when mapped\n", it->first.c_str(), jt->first.c_str());
+				bad++;
+			}
+		}
+		lazy.setCurrentSection(it->first);
+		for(INIFile::key_iterator jt = it->second.begin(); jt != it->second.end(); jt++) {
+			std::string const* value = lazy.findKey(jt->first);
+			if(value == NULL || *value != jt->second.str) {
+				fprintf(stderr, "[%s] %s differs when lazy\n", it->first.c_str(), jt->first.c_str());
+				bad++;
+			}
+		}
+		if(static_cast<size_t>(std::distance(lazy.keysBegin(), lazy.keysEnd())) != sectionKeys) {
+			fprintf(stderr, "[%s] has a different number of keys when lazy\n", it->first.c_str());
+			bad++;
+		}
+		if(static_cast<size_t>(mapped.keysEnd() - mapped.keysBegin()) != sectionKeys) {
+			fprintf(stderr, "[%s] has a different number of keys\n", it->first.c_str());
+			bad++;
+		}
+	}
+	if(mapped.numSections() != numSections) {
+		fprintf(stderr, "Different number of sections (%lu vs %lu)\n", numSections, mapped.numSections());
+		bad++;
+	}
+	printf("%lu sections, %lu keys, %lu differences\n", numSections, numKeys, bad);
+	printf("INIFile       %8.3f ms\n", iniTime * 1000);
+	printf("INIFile lazy  %8.3f ms\n", lazyTime * 1000);
+	printf("MappedINIFile %8.3f ms\n", mappedTime * 1000);
+	return bad != 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "INIFile.h"
+#include "INIOverlay.h"
+#include <stdio.h>
+
+/* Writes the result of layering the given INI files (later ones override
+ * earlier ones) as a single INI file
+ */
+int main(int argc, char** argv) {
+	if(argc < 3) {
+		fprintf(stderr, "Usage: (bin) <out-file> <ini-file>...\n");
+		return 1;
+	}
+	std::vector<INIFile*> layers;
+	INIOverlay overlay;
+	for(int i = 2; i < argc; i++) {
+		layers.push_back(new INIFile(argv[i], true));
+		overlay.addLayer(*layers.back());
+	}
+	INIFile merged;
+	for(size_t l = 0; l != layers.size(); l++) {
+		for(INIFile::section_iterator it = layers[l]->sectionsBegin(); it != layers[l]->sectionsEnd(); it++) {
+			merged.setCurrentSection(it->first);
+			for(INIFile::key_iterator jt = it->second.begin(); jt != it->second.end(); jt++) {
+				std::string const* val = overlay.findKey(it->first, jt->first);
+				if(val == NULL) {
+					throw EXCEPTION("[%s] %s missing from overlay", it->first.c_str(), jt->first.c_str());
+				}
+				merged.setKey(jt->first, *val);
+			}
+		}
+	}
+	merged.write(argv[1]);
+	for(size_t l = 0; l != layers.size(); l++) {
+		delete layers[l];
+	}
+	return 0;
+}
@@ -0,0 +1,200 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+
+#include "LZOCompress.h"
+#include "LZODecompress.h"
+#include "Exception.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <vector>
+
+/* Differential test and benchmark of LZODecompress::decompressFast against
+ * minilzo's lzo1x_decompress_safe (LZODecompress::decompress).  Valid
+ * streams come from LZOCompress, the corrupted ones are those with a few
+ * bytes changed or cut off the end; on every stream the two must either
+ * both fail or both return the same data
+ */
+
+namespace {
+	double now() {
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		return tv.tv_sec + tv.tv_usec / 1000000.0;
+	}
+
+	size_t pick(size_t lo, size_t hi) {
+		return lo + rand() % (hi - lo + 1);
+	}
+
+	/* IsoMapPack5 style data: 11 byte cells walking across the map with
+	 * mostly repeated tiles, plus the odd run of noise and of zeros
+	 */
+	void generate(std::vector<uint8_t>& data, size_t len) {
+		data.resize(len);
+		size_t i = 0;
+		uint16_t x = rand() % 512, y = rand() % 512, tile = rand() % 40;
+		while(i < len) {
+			unsigned int kind = rand() % 16;
+			if(kind == 0) {
+				for(size_t n = pick(1, 300); n != 0 && i < len; n--) {
+					data[i++] = rand();
+				}
+			} else if(kind == 1) {
+				for(size_t n = pick(1, 3000); n != 0 && i < len; n--) {
+					data[i++] = 0;
+				}
+			} else {
+				if(rand() % 8 == 0) {
+					tile = rand() % 400;
+				}
+				uint8_t cell[11] = {
+					static_cast<uint8_t>(x), static_cast<uint8_t>(x >> 8),
+					static_cast<uint8_t>(y), static_cast<uint8_t>(y >> 8),
+					static_cast<uint8_t>(tile), static_cast<uint8_t>(tile >> 8),
+					0, 0, static_cast<uint8_t>(rand() % 4), static_cast<uint8_t>(rand() % 3 ? 0 : 1), 0,
+				};
+				x++;
+				for(size_t n = 0; n != 11 && i < len; n++) {
+					data[i++] = cell[n];
+				}
+			}
+		}
+	}
+
+	void compress(std::vector<uint8_t> const& data, std::vector<uint8_t>& packed) {
+		packed.resize(LZOCompress::maxCompressedSize(data.size()));
+		packed.resize(LZOCompress::compress(&data[0], &packed[0], data.size(), packed.size()));
+	}
+
+	/* Returns the decompressed length, or -1 if it threw */
+	long tryDecompress(bool fast, std::vector<uint8_t> const& in, size_t inLen, std::vector<uint8_t>& out) {
+		try {
+			if(fast) {
+				return LZODecompress::decompressFast(&in[0], &out[0], inLen, out.size());
+			}
+			return LZODecompress::decompress(&in[0], &out[0], inLen, out.size());
+		} catch(Exception& e) {
+			return -1;
+		}
+	}
+
+	bool check(unsigned int iterations) {
+		std::vector<uint8_t> data, in, ref, got;
+		size_t rejected = 0, corrupted = 0;
+		for(unsigned int it = 0; it != iterations; it++) {
+			/* Bigger than a pack section now and then for the long distance matches */
+			size_t len = rand() % 8 ? pick(1, 8192) : pick(8192, 65536);
+			generate(data, len);
+			compress(data, in);
+			size_t inLen = in.size();
+			/* minilzo can read a couple of bytes past the end of bad input */
+			in.insert(in.end(), 16, 0);
+			/* Sometimes exactly the right amount of room, sometimes more */
+			size_t outLen = rand() % 2 ? len : len + pick(1, 64);
+			ref.assign(outLen, 0);
+			got.assign(outLen, 0);
+			long refLen = tryDecompress(false, in, inLen, ref);
+			long gotLen = tryDecompress(true, in, inLen, got);
+			if(refLen != static_cast<long>(len) || gotLen != refLen || memcmp(&ref[0], &got[0], len) != 0 || memcmp(&got[0], &data[0], len) != 0) {
+				fprintf(stderr, "Iteration %u: decompressors differ on a valid stream (%li, %li, %lu)\n", it, refLen, gotLen, len);
+				return false;
+			}
+			for(unsigned int c = 0; c != 8; c++) {
+				std::vector<uint8_t> bad(in);
+				size_t badLen = inLen, badOut = outLen;
+				if(c == 0) {
+					badLen = pick(0, inLen - 1);
+				} else if(c == 1) {
+					badOut = pick(0, len);
+				} else {
+					for(unsigned int n = pick(1, 4); n != 0; n--) {
+						bad[rand() % inLen] = rand();
+					}
+				}
+				ref.assign(badOut, 0);
+				got.assign(badOut, 0);
+				refLen = tryDecompress(false, bad, badLen, ref);
+				gotLen = tryDecompress(true, bad, badLen, got);
+				corrupted++;
+				if(refLen != gotLen || (gotLen > 0 && memcmp(&ref[0], &got[0], gotLen) != 0)) {
+					fprintf(stderr, "Iteration %u/%u: decompressors differ on a corrupted stream (%li, %li)\n", it, c, refLen, gotLen);
+					return false;
+				}
+				if(gotLen == -1) {
+					rejected++;
+				}
+			}
+		}
+		printf("%u valid streams, %lu corrupted (%lu rejected) all agree\n", iterations, corrupted, rejected);
+		return true;
+	}
+
+	double bench(bool fast, std::vector<std::vector<uint8_t> > const& streams, size_t sectionLen, unsigned int iterations) {
+		std::vector<uint8_t> out(sectionLen);
+		double start = now();
+		for(unsigned int i = 0; i != iterations; i++) {
+			for(size_t s = 0; s != streams.size(); s++) {
+				size_t len = fast ?
+					LZODecompress::decompressFast(&streams[s][0], &out[0], streams[s].size(), out.size()) :
+					LZODecompress::decompress(&streams[s][0], &out[0], streams[s].size(), out.size());
+				if(len != sectionLen) {
+					throw EXCEPTION("Decompressed %lu bytes, expected %lu", len, sectionLen);
+				}
+			}
+		}
+		return (now() - start) / iterations;
+	}
+}
+
+int main(int argc, char** argv) {
+	unsigned int checks = 2000;
+	unsigned int iterations = 20;
+	if(argc > 1) {
+		checks = atoi(argv[1]);
+	}
+	if(argc > 2) {
+		iterations = atoi(argv[2]);
+	}
+	srand(1);
+	if(!check(checks)) {
+		return 1;
+	}
+
+	/* A large IsoMapPack5 (about 100000 cells) in 8K sections */
+	size_t const sectionLen = 8192;
+	std::vector<std::vector<uint8_t> > streams(1100000 / sectionLen);
+	std::vector<uint8_t> data;
+	size_t packed = 0;
+	for(size_t s = 0; s != streams.size(); s++) {
+		generate(data, sectionLen);
+		compress(data, streams[s]);
+		packed += streams[s].size();
+	}
+	double refTime = bench(false, streams, sectionLen, iterations);
+	double fastTime = bench(true, streams, sectionLen, iterations);
+	double mb = static_cast<double>(streams.size() * sectionLen) / (1 << 20);
+	printf("%lu bytes packed into %lu\n", streams.size() * sectionLen, packed);
+	printf("decompress     %8.1f MB/s\n", mb / refTime);
+	printf("decompressFast %8.1f MB/s\n", mb / fastTime);
+	return 0;
+}
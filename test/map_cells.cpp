@@ -0,0 +1,65 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "Base64.h"
+#include "INIFile.h"
+#include "IsoMapPack.h"
+#include "MapReader.h"
+#include "Exception.h"
+#include "Utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Loads a map's IsoMapPack5 and either prints the cell at a position or
+ * lists the cells using a range of tiles
+ */
+int main(int argc, char** argv) {
+	if(argc != 2 && argc != 4 && !(argc == 5 && argv[2][0] == 't')) {
+		fprintf(stderr, "Usage: (bin) <map-file> [<x> <y> | t <first-tile> <last-tile>]\n");
+		return 1;
+	}
+	INIFile ini(argv[1], true);
+	ini.setCurrentSection("IsoMapPack5");
+	size_t len, unpackedLen;
+	Utils::ScopedArray<uint8_t> data(Base64::decode(ini, len));
+	Utils::ScopedArray<uint8_t> unpacked(MapReader::unpack(data.ptr, len, unpackedLen, MapReader::LZOPack));
+	IsoMapPack iso(unpacked.ptr, unpackedLen);
+	if(argc == 2) {
+		iso.print();
+	} else if(argc == 4) {
+		uint32_t c = iso.findCell(atoi(argv[2]), atoi(argv[3]));
+		if(c == IsoMapPack::noCell) {
+			printf("No cell at (%s, %s)\n", argv[2], argv[3]);
+		} else {
+			printf("Cell %u - position (%i, %i, %i), tile %i / %i\n", c,
+				iso.getX()[c], iso.getY()[c], iso.getZ()[c], iso.getTile()[c], iso.getSubTile()[c]);
+		}
+	} else {
+		std::vector<uint32_t> cells;
+		iso.findTiles(atoi(argv[3]), atoi(argv[4]), cells);
+		printf("%lu of %u cells use tiles %s - %s\n", cells.size(), iso.numCells(), argv[3], argv[4]);
+		for(size_t i = 0; i != cells.size(); i++) {
+			uint32_t c = cells[i];
+			printf("Cell %u - position (%i, %i), tile %i / %i\n", c,
+				iso.getX()[c], iso.getY()[c], iso.getTile()[c], iso.getSubTile()[c]);
+		}
+	}
+	return 0;
+}
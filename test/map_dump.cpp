@@ -20,6 +20,7 @@
 #include "Base64.h"
 #include "LZODecompress.h"
 #include "MapReader.h"
+#include "MapPreview.h"
 #include "Palette.h"
 #include "Exception.h"
 #include "Utils.h"
@@ -52,12 +53,11 @@ int main(int argc, char** argv) {
 	}
 	uint8_t* data;
 	uint8_t* unpacked;
-	unsigned int previewWidth = 160;
-	unsigned int previewHeight = 80;
+	uint32_t previewWidth, previewHeight;
 	FILE* f;
 	size_t len, unpackedLen;
 	std::ostringstream fname;
-	INIFile ini(argv[1]);
+	INIFile ini(argv[1], true);
 	for(unsigned int i = 0; i < NUM_PACKS; i++) {
 		if(argc > 2 && strcmp(pack[i], argv[2])) {
 			continue;
@@ -76,24 +76,13 @@ int main(int argc, char** argv) {
 		f = fopen(fname.str().c_str(), "wb");
 		fwrite(unpacked, 1, unpackedLen, f);
 		fclose(f);
-		if(strcmp(pack[i], "PreviewPack") == 0) {
-			SDL_Surface* img = SDL_CreateRGBSurface(SDL_SWSURFACE, previewWidth, previewHeight, 32, 0, 0, 0, 0);
+		if(strcmp(pack[i], "PreviewPack") == 0 && MapPreview::getSize(ini, previewWidth, previewHeight)) {
+			Utils::ScopedArray<uint8_t> rgba(new uint8_t[previewWidth * previewHeight * 4]);
+			MapPreview::decode(ini, rgba.ptr, previewWidth, previewHeight);
+			SDL_Surface* img = SDL_CreateRGBSurfaceFrom(rgba.ptr, previewWidth, previewHeight, 32, previewWidth * 4,
+				0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
 			if(img == NULL) {
-				throw EXCEPTION("Arg");
-			}
-			{
-				SDL::ScopedSurfaceLock lock(img);
-				uint32_t* opx = reinterpret_cast<uint32_t*>(img->pixels);
-				for(unsigned int j = 0; j != previewWidth * previewHeight; j++) {
-					*opx = SDL_MapRGBA(
-						img->format,
-						unpacked[j * 3],
-						unpacked[(j * 3) + 1],
-						unpacked[(j * 3) + 2],
-						255
-					);
-					opx++;
-				}
+				throw EXCEPTION("Could not create %u x %u surface", previewWidth, previewHeight);
 			}
 			SDL_SaveBMP(img, "tmp.bmp");
 			SDL_FreeSurface(img);
@@ -0,0 +1,144 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+
+#include "Base64.h"
+#include "INIFile.h"
+#include "MapIndex.h"
+#include "MapList.h"
+#include "MapReader.h"
+#include "RadarRenderer.h"
+#include "TheaterCache.h"
+#include "WorkQueue.h"
+#include "Exception.h"
+#include "Utils.h"
+#include <sys/stat.h>
+
+/* Builds or updates a map catalogue.  A map whose size and modification
+ * time match its old entry isn't read at all; one that has been touched
+ * but hashes the same keeps its old metadata.  Only the rest are parsed.
+ */
+struct IndexList : public MapList {
+	enum Status { Unchanged = 1, Touched, Indexed };
+	MapIndex const& old;
+	TheaterCache* theaters;
+	std::vector<MapIndex::Entry> entries;
+	IndexList(MapIndex const& o, TheaterCache* t) : old(o), theaters(t) { }
+	void runAll() {
+		entries.assign(size(), MapIndex::Entry());
+		MapList::runAll();
+	}
+	uint8_t process(size_t n, std::string const& file) {
+		MapIndex::Entry& entry = entries[n];
+		struct stat st;
+		if(stat(file.c_str(), &st) != 0) {
+			throw EXCEPTION("Could not stat file (%s)", strerror(errno));
+		}
+		int64_t modified = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+		MapIndex::Entry const* prev = old.find(file);
+		if(prev != NULL && prev->fileSize == static_cast<uint64_t>(st.st_size) && prev->modified == modified) {
+			entry = *prev;
+			return Unchanged;
+		}
+		std::vector<char> data(st.st_size);
+		FILE* f = fopen(file.c_str(), "rb");
+		if(f == NULL) {
+			throw EXCEPTION("Could not open file (%s)", strerror(errno));
+		}
+		Utils::ScopedFile f_close(f);
+		if(!data.empty() && fread(&data[0], 1, data.size(), f) != data.size()) {
+			throw EXCEPTION("Could not read %lu bytes (%s)", data.size(), strerror(errno));
+		}
+		uint64_t hash = MapIndex::hash(reinterpret_cast<uint8_t const*>(data.empty() ? NULL : &data[0]), data.size());
+		uint8_t result = Touched;
+		if(prev != NULL && prev->hash == hash) {
+			entry = *prev;
+		} else {
+			entry = MapIndex::Entry();
+			INIFile ini;
+			ini.read(data.empty() ? NULL : &data[0], data.size(), true);
+			entry.readMetadata(ini);
+			if(theaters != NULL) {
+				radar(ini, entry);
+			}
+			result = Indexed;
+		}
+		entry.path = file;
+		entry.fileSize = st.st_size;
+		entry.modified = modified;
+		entry.hash = hash;
+		return result;
+	}
+	void radar(INIFile& ini, MapIndex::Entry& entry) {
+		Theater const& theater = theaters->get(entry.theater);
+		size_t len, unpackedLen;
+		ini.setCurrentSection("IsoMapPack5");
+		Utils::ScopedArray<uint8_t> data(Base64::decode(ini, len));
+		Utils::ScopedArray<uint8_t> unpacked(MapReader::unpack(data.ptr, len, unpackedLen, MapReader::LZOPack, 1));
+		MapReader map;
+		map.readIsoMapPack(unpacked.ptr, unpackedLen);
+		RadarRenderer radar(map);
+		uint32_t w, h;
+		radar.getSize(w, h);
+		/* A map is at most 512 x 512 cells, which is 1024 pixels across in either direction */
+		if(w > 1024 || h > 1024) {
+			throw EXCEPTION("Radar image of %u x %u is too large", w, h);
+		}
+		Utils::ScopedArray<uint8_t> rgba(new uint8_t[static_cast<size_t>(w) * h * 4]);
+		radar.render(rgba.ptr, theater);
+		entry.radar.fromRGBA(rgba.ptr, w, h);
+	}
+};
+
+int main(int argc, char** argv) {
+	if(argc < 4) {
+		fprintf(stderr, "Usage: (bin) <index-file> <theater-data-dir|-> <map-file|map-dir>...\n");
+		return 1;
+	}
+	std::string indexFile(argv[1]);
+	MapIndex old;
+	struct stat st;
+	if(stat(indexFile.c_str(), &st) == 0) {
+		try {
+			old.read(indexFile);
+		} catch(Exception& e) {
+			fprintf(stderr, "Ignoring old index: %s\n", e.what());
+		}
+	}
+	TheaterCache* theaters = NULL;
+	if(strcmp(argv[2], "-") != 0) {
+		theaters = new TheaterCache(argv[2]);
+	}
+	IndexList list(old, theaters);
+	list.add(&argv[3], argc - 3);
+	list.runAll();
+	delete theaters;
+
+	MapIndex index;
+	for(size_t i = 0; i != list.size(); i++) {
+		if(list.getStatus(i) != MapList::Failed) {
+			index.set(list.entries[i]);
+		}
+	}
+	index.write(indexFile);
+	printf("%lu maps: %lu unchanged, %lu touched, %lu indexed, %lu failed\n", list.size(),
+		list.count(IndexList::Unchanged), list.count(IndexList::Touched), list.count(IndexList::Indexed), list.count(MapList::Failed));
+	return list.count(MapList::Failed) != 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+
+#include "INIFile.h"
+#include "MapList.h"
+#include "MapPreview.h"
+#include "WorkQueue.h"
+#include "Exception.h"
+#include "Utils.h"
+#include "SDLUtils.h"
+#include <SDL/SDL.h>
+
+/* Maps are spread over all the processors, each preview is decoded on the
+ * thread that loaded it
+ */
+struct PreviewList : public MapList {
+	enum Status { NoPreview = 1, Saved };
+	uint8_t process(size_t, std::string const& file) {
+		INIFile ini(file, true);
+		uint32_t w, h;
+		if(!MapPreview::getSize(ini, w, h)) {
+			fprintf(stderr, "%s: No preview\n", file.c_str());
+			return NoPreview;
+		}
+		Utils::ScopedArray<uint8_t> rgba(new uint8_t[static_cast<size_t>(w) * h * 4]);
+		MapPreview::decode(ini, rgba.ptr, w, h);
+		SDL_Surface* img = SDL_CreateRGBSurfaceFrom(rgba.ptr, w, h, 32, w * 4, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+		if(img == NULL) {
+			throw EXCEPTION("Could not create %u x %u surface", w, h);
+		}
+		SDL::ScopedSurface img_free(img);
+		SDL_SaveBMP(img, (file + "-preview.bmp").c_str());
+		return Saved;
+	}
+};
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		fprintf(stderr, "Usage: (bin) <map-file|map-dir>...\n");
+		return 1;
+	}
+	PreviewList list;
+	list.add(&argv[1], argc - 1);
+	list.runAll();
+	printf("Saved %lu of %lu previews\n", list.count(PreviewList::Saved), list.size());
+	return list.count(MapList::Failed) != 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "Base64.h"
+#include "MapList.h"
+#include "MapReader.h"
+#include "RadarRenderer.h"
+#include "TheaterCache.h"
+#include "WorkQueue.h"
+#include "Exception.h"
+#include "Utils.h"
+#include "SDLUtils.h"
+#include <SDL/SDL.h>
+#include <sstream>
+
+struct RadarList : public MapList {
+	enum { Saved = 1 };
+	TheaterCache& theaters;
+	RadarList(TheaterCache& t) : theaters(t) { }
+	uint8_t process(size_t, std::string const& file) {
+		size_t len, unpackedLen;
+		INIFile ini(file, true);
+		ini.setCurrentSection("Map");
+		Theater const& theater = theaters.get(ini.getKey("Theater"));
+		ini.setCurrentSection("IsoMapPack5");
+		uint8_t* data = Base64::decode(ini, len);
+		Utils::ScopedArray<uint8_t> data_free(data);
+		uint8_t* unpacked = MapReader::unpack(data, len, unpackedLen, MapReader::LZOPack, 1);
+		Utils::ScopedArray<uint8_t> unpacked_free(unpacked);
+		MapReader map;
+		map.readIsoMapPack(unpacked, unpackedLen);
+
+		RadarRenderer radar(map);
+		uint32_t w, h;
+		radar.getSize(w, h);
+		uint8_t* rgba = new uint8_t[w * h * 4];
+		Utils::ScopedArray<uint8_t> rgba_free(rgba);
+		radar.render(rgba, theater);
+		SDL_Surface* img = SDL_CreateRGBSurfaceFrom(rgba, w, h, 32, w * 4, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+		if(img == NULL) {
+			throw EXCEPTION("Could not create %u x %u surface", w, h);
+		}
+		SDL::ScopedSurface img_free(img);
+		SDL_SaveBMP(img, (file + "-radar.bmp").c_str());
+		return Saved;
+	}
+};
+
+int main(int argc, char** argv) {
+	if(argc < 3) {
+		fprintf(stderr, "Usage: (bin) <theater-data-dir> <map-file|map-dir>...\n");
+		return 1;
+	}
+	TheaterCache theaters(argv[1]);
+	RadarList list(theaters);
+	list.add(&argv[2], argc - 2);
+	list.runAll();
+	printf("Processed %lu maps\n", list.size());
+	return list.count(MapList::Failed) != 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+
+#include "INIFile.h"
+#include "MapReader.h"
+#include "MapWriter.h"
+#include "PackCache.h"
+#include "Exception.h"
+#include "Utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <vector>
+
+/* Times what a map editor does after each save: reloading the map.  The
+ * first load fills the cache, then the map is reloaded unchanged and again
+ * after one pack has been edited and the map saved with MapWriter
+ */
+
+namespace {
+	struct PackInfo {
+		char const* name;
+		int format;
+	};
+	PackInfo const packs[] = {
+		{"PreviewPack", MapReader::LZOPack},
+		{"IsoMapPack5", MapReader::LZOPack},
+		{"OverlayPack", MapReader::F80Pack},
+		{"OverlayDataPack", MapReader::F80Pack},
+	};
+	size_t const numPacks = sizeof(packs) / sizeof(packs[0]);
+
+	double now() {
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		return tv.tv_sec + tv.tv_usec / 1000000.0;
+	}
+
+	/* Loads every pack in the map, returning the time taken */
+	double load(PackCache& cache, std::string const& file, unsigned int iterations) {
+		double start = now();
+		for(unsigned int i = 0; i != iterations; i++) {
+			INIFile ini(file, true);
+			for(size_t p = 0; p != numPacks; p++) {
+				if(ini.sectionExists(packs[p].name)) {
+					size_t len;
+					cache.get(ini, packs[p].name, packs[p].format, len);
+				}
+			}
+		}
+		return (now() - start) / iterations;
+	}
+
+	/* Writes the map with every pack that has data */
+	void save(INIFile& ini, std::vector<uint8_t> const* data, std::string const& file) {
+		MapWriter writer(ini);
+		for(size_t p = 0; p != numPacks; p++) {
+			if(!data[p].empty()) {
+				writer.setPack(packs[p].name, &data[p][0], data[p].size(), packs[p].format);
+			}
+		}
+		writer.write(file);
+	}
+}
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		fprintf(stderr, "Usage: (bin) <map-file> [<iterations>]\n");
+		return 1;
+	}
+	std::string file(argv[1]);
+	unsigned int iterations = argc > 2 ? atoi(argv[2]) : 10;
+
+	PackCache cache;
+	double cold = load(cache, file, 1);
+	printf("First load   %8.2f ms (%lu packs unpacked, %lu bytes cached)\n", cold * 1000, cache.getMisses(), cache.size());
+
+	unsigned long misses = cache.getMisses();
+	double warm = load(cache, file, iterations);
+	unsigned long warmMisses = cache.getMisses() - misses;
+	printf("Unchanged    %8.2f ms (%lu packs unpacked)\n", warm * 1000, warmMisses / iterations);
+
+	/* Read every pack and save the map elsewhere, as an editor would.  The
+	 * packs are written with MapWriter's encoders, which need not match
+	 * whatever wrote the original map, so that copy is loaded once first
+	 */
+	INIFile ini(file, true);
+	std::vector<uint8_t> data[numPacks];
+	size_t edited = numPacks;
+	for(size_t p = 0; p != numPacks; p++) {
+		if(!ini.sectionExists(packs[p].name)) {
+			continue;
+		}
+		size_t len;
+		uint8_t const* d = cache.get(ini, packs[p].name, packs[p].format, len);
+		data[p].assign(d, d + len);
+		if(edited == numPacks && len != 0) {
+			edited = p;
+		}
+	}
+	if(edited == numPacks) {
+		fprintf(stderr, "Map has no packs\n");
+		return 1;
+	}
+	std::string savedFile = file + "-reload.tmp";
+	save(ini, data, savedFile);
+	load(cache, savedFile, 1);
+
+	/* Edit the first pack the map has and save again; reloading should only
+	 * unpack the pack that changed
+	 */
+	for(size_t i = 0; i < data[edited].size(); i += 97) {
+		data[edited][i] ^= 0x55;
+	}
+	save(ini, data, savedFile);
+	misses = cache.getMisses();
+	double edit = load(cache, savedFile, 1);
+	remove(savedFile.c_str());
+	unsigned long editMisses = cache.getMisses() - misses;
+	printf("One edit     %8.2f ms (%lu packs unpacked, [%s] changed)\n", edit * 1000, editMisses, packs[edited].name);
+
+	/* For comparison, unpacking everything every time */
+	double start = now();
+	for(unsigned int i = 0; i != iterations; i++) {
+		cache.clear();
+		load(cache, file, 1);
+	}
+	printf("No cache     %8.2f ms\n", (now() - start) / iterations * 1000);
+
+	if(warmMisses != 0 || editMisses != 1) {
+		fprintf(stderr, "Expected 0 packs unpacked when unchanged and 1 after one edit\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "Base64.h"
+#include "MapReader.h"
+#include "MapRenderer.h"
+#include "Theater.h"
+#include "Palette.h"
+#include "Exception.h"
+#include "Utils.h"
+#include "SDLUtils.h"
+#include <SDL/SDL.h>
+#include <stdlib.h>
+#include <sstream>
+
+int main(int argc, char** argv) {
+	if(argc < 6) {
+		fprintf(stderr, "Usage: (bin) <map-file> <theater-ini> <tile-dir> <tile-ext> <pal-file> [<threads> [z]]\n");
+		return 1;
+	}
+	unsigned int threads = argc > 6 ? atoi(argv[6]) : 0;
+	bool useDepth = argc > 7 && strcmp(argv[7], "z") == 0;
+	size_t len, unpackedLen;
+	INIFile ini(argv[1], true);
+	ini.setCurrentSection("IsoMapPack5");
+	uint8_t* data = Base64::decode(ini, len);
+	Utils::ScopedArray<uint8_t> data_free(data);
+	uint8_t* unpacked = MapReader::unpack(data, len, unpackedLen, MapReader::LZOPack);
+	Utils::ScopedArray<uint8_t> unpacked_free(unpacked);
+
+	MapReader map;
+	map.readIsoMapPack(unpacked, unpackedLen);
+	Theater theater(argv[2], argv[3], argv[4]);
+	Palette pal(argv[5]);
+	MapRenderer renderer(map, theater);
+
+	uint32_t w, h;
+	renderer.getSize(w, h);
+	SDL_Surface* img = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+	if(img == NULL) {
+		throw EXCEPTION("Could not create %u x %u surface", w, h);
+	}
+	SDL::ScopedSurface img_free(img);
+	{
+		SDL::ScopedSurfaceLock lock(img);
+		if(img->pitch == w * 4) {
+			renderer.renderRGBA(static_cast<uint8_t*>(img->pixels), pal, threads, useDepth);
+		} else {
+			uint8_t* rgba = new uint8_t[w * h * 4];
+			Utils::ScopedArray<uint8_t> rgba_free(rgba);
+			renderer.renderRGBA(rgba, pal, threads, useDepth);
+			for(uint32_t y = 0; y != h; y++) {
+				memcpy(static_cast<uint8_t*>(img->pixels) + y * img->pitch, rgba + y * w * 4, w * 4);
+			}
+		}
+	}
+	std::ostringstream fname;
+	fname << argv[1] << "-render.bmp";
+	SDL_SaveBMP(img, fname.str().c_str());
+	return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "Base64.h"
+#include "INIFile.h"
+#include "MapReader.h"
+#include "Exception.h"
+#include "Utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+/* Unpacks each pack in a map, packs it again and checks the result unpacks
+ * to the same data, reporting sizes and how long packing took
+ */
+
+namespace {
+	struct PackInfo {
+		char const* name;
+		int format;
+	};
+	PackInfo const packs[] = {
+		{"PreviewPack", MapReader::LZOPack},
+		{"IsoMapPack5", MapReader::LZOPack},
+		{"OverlayPack", MapReader::F80Pack},
+		{"OverlayDataPack", MapReader::F80Pack},
+	};
+
+	double now() {
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		return tv.tv_sec + tv.tv_usec / 1000000.0;
+	}
+}
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		fprintf(stderr, "Usage: (bin) <map-file> [threads]\n");
+		return 1;
+	}
+	unsigned int threads = 0;
+	if(argc > 2) {
+		threads = atoi(argv[2]);
+	}
+	INIFile ini(argv[1], true);
+	bool ok = true;
+	for(size_t p = 0; p != sizeof(packs) / sizeof(packs[0]); p++) {
+		if(!ini.sectionExists(packs[p].name)) {
+			continue;
+		}
+		ini.setCurrentSection(packs[p].name);
+		size_t len, unpackedLen, repackedLen, checkLen;
+		Utils::ScopedArray<uint8_t> data(Base64::decode(ini, len));
+		Utils::ScopedArray<uint8_t> unpacked(MapReader::unpack(data.ptr, len, unpackedLen, packs[p].format, threads));
+		double start = now();
+		Utils::ScopedArray<uint8_t> repacked(MapReader::pack(unpacked.ptr, unpackedLen, repackedLen, packs[p].format, 8192, threads));
+		double t = now() - start;
+		Utils::ScopedArray<uint8_t> check(MapReader::unpack(repacked.ptr, repackedLen, checkLen, packs[p].format, threads));
+		bool same = checkLen == unpackedLen && memcmp(check.ptr, unpacked.ptr, checkLen) == 0;
+		ok = ok && same;
+		printf("%-16s %8lu bytes, packed %8lu -> %8lu in %7.2f ms%s\n",
+			packs[p].name, unpackedLen, len, repackedLen, t * 1000, same ? "" : " MISMATCH");
+	}
+	return ok ? 0 : 1;
+}
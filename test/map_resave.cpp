@@ -0,0 +1,121 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "Base64.h"
+#include "INIFile.h"
+#include "MapReader.h"
+#include "MapWriter.h"
+#include "WorkQueue.h"
+#include "Exception.h"
+#include "Utils.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <vector>
+
+/* Reads each map, unpacks its packs and writes it again with MapWriter into
+ * the output directory, then checks the new file unpacks to the same data.
+ * Maps are spread over the processors, each one handled on a single thread
+ */
+
+namespace {
+	struct PackInfo {
+		char const* name;
+		int format;
+	};
+	PackInfo const packs[] = {
+		{"PreviewPack", MapReader::LZOPack},
+		{"IsoMapPack5", MapReader::LZOPack},
+		{"OverlayPack", MapReader::F80Pack},
+		{"OverlayDataPack", MapReader::F80Pack},
+	};
+	size_t const numPacks = sizeof(packs) / sizeof(packs[0]);
+
+	/* Returns the unpacked pack, or NULL if the map doesn't have it */
+	uint8_t* readPack(INIFile& ini, PackInfo const& pack, size_t& len) {
+		if(!ini.sectionExists(pack.name)) {
+			return NULL;
+		}
+		ini.setCurrentSection(pack.name);
+		size_t packedLen;
+		Utils::ScopedArray<uint8_t> packed(Base64::decode(ini, packedLen));
+		return MapReader::unpack(packed.ptr, packedLen, len, pack.format, 1);
+	}
+
+	struct ResaveTask : public WorkQueue::Task {
+		std::string outDir;
+		char** maps;
+		ResaveTask(std::string const& o, char** m) : outDir(o), maps(m) { }
+
+		void run(size_t n) {
+			INIFile ini(maps[n], true);
+			uint8_t* data[numPacks] = { NULL };
+			size_t len[numPacks];
+			char const* base = strrchr(maps[n], '/');
+			std::string outFile = outDir + "/" + (base != NULL ? base + 1 : maps[n]);
+			try {
+				/* A bad pack mustn't leak the ones unpacked before it */
+				for(size_t p = 0; p != numPacks; p++) {
+					data[p] = readPack(ini, packs[p], len[p]);
+				}
+				MapWriter writer(ini, 1);
+				for(size_t p = 0; p != numPacks; p++) {
+					if(data[p] != NULL) {
+						writer.setPack(packs[p].name, data[p], len[p], packs[p].format);
+					}
+				}
+				writer.write(outFile);
+
+				INIFile check(outFile, true);
+				for(size_t p = 0; p != numPacks; p++) {
+					size_t checkLen;
+					Utils::ScopedArray<uint8_t> checkData(readPack(check, packs[p], checkLen));
+					if((data[p] == NULL) != (checkData.ptr == NULL) ||
+							(data[p] != NULL && (checkLen != len[p] || memcmp(data[p], checkData.ptr, checkLen) != 0))) {
+						throw EXCEPTION("%s differs after writing %s", packs[p].name, outFile.c_str());
+					}
+				}
+			} catch(...) {
+				for(size_t p = 0; p != numPacks; p++) {
+					delete[] data[p];
+				}
+				throw;
+			}
+			for(size_t p = 0; p != numPacks; p++) {
+				delete[] data[p];
+			}
+		}
+	};
+}
+
+int main(int argc, char** argv) {
+	if(argc < 3) {
+		fprintf(stderr, "Usage: (bin) <out-dir> <map-file>...\n");
+		return 1;
+	}
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+	ResaveTask task(argv[1], &argv[2]);
+	WorkQueue::run(task, argc - 2);
+	gettimeofday(&end, NULL);
+	printf("Wrote %i maps in %.1f ms\n", argc - 2,
+		(end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0);
+	return 0;
+}
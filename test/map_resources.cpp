@@ -0,0 +1,113 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+
+#include "Base64.h"
+#include "INIFile.h"
+#include "MapReader.h"
+#include "OverlayGrid.h"
+#include "WorkQueue.h"
+#include "Exception.h"
+#include "Utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Resource and wall totals for many maps, spread over all the processors.
+ * Each map's report is built up in a string so the output stays in the
+ * order the maps were given.  The overlay classes are worked out from the
+ * rules once, up front, and copied into each map's grid.
+ */
+struct ResourceTask : public WorkQueue::Task {
+	uint8_t const* classes;
+	uint32_t regionSize;
+	char** maps;
+	std::vector<std::string> reports;
+	ResourceTask(uint8_t const* c, uint32_t s, char** m, size_t n) : classes(c), regionSize(s), maps(m), reports(n) { }
+	void run(size_t n) {
+		try {
+			reports[n] = report(maps[n]);
+		} catch(Exception& e) {
+			reports[n] = std::string(maps[n]) + ": " + e.what() + "\n";
+		}
+	}
+	static uint8_t* unpackSection(INIFile& ini, char const* section, size_t& len) {
+		size_t packedLen;
+		ini.setCurrentSection(section);
+		Utils::ScopedArray<uint8_t> packed(Base64::decode(ini, packedLen));
+		return MapReader::unpack(packed.ptr, packedLen, len, MapReader::F80Pack, 1);
+	}
+	std::string report(char const* file) {
+		INIFile ini(file, true);
+		size_t overlayLen, dataLen;
+		Utils::ScopedArray<uint8_t> overlay(unpackSection(ini, "OverlayPack", overlayLen));
+		Utils::ScopedArray<uint8_t> data(unpackSection(ini, "OverlayDataPack", dataLen));
+		OverlayGrid grid(overlay.ptr, overlayLen, data.ptr, dataLen);
+		grid.setClasses(classes);
+		std::vector<OverlayGrid::WallSegment> walls;
+		grid.listWalls(walls);
+		OverlayGrid::ResourceCount total = grid.countResources(0, 0, OverlayGrid::size, OverlayGrid::size);
+
+		char line[256];
+		snprintf(line, sizeof(line), "%s: ore %u cells (%u), gems %u cells (%u), %lu wall segments\n", file,
+			total.oreCells, total.oreAmount, total.gemCells, total.gemAmount, walls.size());
+		std::string out(line);
+		if(regionSize != 0) {
+			std::vector<OverlayGrid::ResourceCount> regions;
+			uint32_t across = grid.countResourcesByRegion(regionSize, regions);
+			for(size_t i = 0; i != regions.size(); i++) {
+				OverlayGrid::ResourceCount const& r = regions[i];
+				if(r.oreCells == 0 && r.gemCells == 0) {
+					continue;
+				}
+				snprintf(line, sizeof(line), "\tregion (%u, %u): ore %u cells (%u), gems %u cells (%u)\n",
+					static_cast<uint32_t>(i % across) * regionSize, static_cast<uint32_t>(i / across) * regionSize,
+					r.oreCells, r.oreAmount, r.gemCells, r.gemAmount);
+				out += line;
+			}
+			for(size_t i = 0; i != walls.size(); i++) {
+				OverlayGrid::WallSegment const& w = walls[i];
+				snprintf(line, sizeof(line), "\twall %u: %u cells from (%u, %u), bounds (%u, %u) - (%u, %u)\n",
+					w.overlay, w.cells, w.firstX, w.firstY, w.minX, w.minY, w.maxX, w.maxY);
+				out += line;
+			}
+		}
+		return out;
+	}
+};
+
+int main(int argc, char** argv) {
+	if(argc < 4) {
+		fprintf(stderr, "Usage: (bin) <rules-ini|-> <region-size|0> <map-file>...\n");
+		return 1;
+	}
+	std::vector<uint8_t> classes(OverlayGrid::classTableSize);
+	OverlayGrid::defaultClasses(&classes[0]);
+	if(strcmp(argv[1], "-") != 0) {
+		INIFile rules(argv[1]);
+		OverlayGrid::buildClasses(rules, &classes[0]);
+	}
+	ResourceTask task(&classes[0], atoi(argv[2]), &argv[3], argc - 3);
+	WorkQueue::run(task, argc - 3);
+	for(size_t i = 0; i != task.reports.size(); i++) {
+		fputs(task.reports[i].c_str(), stdout);
+	}
+	return 0;
+}
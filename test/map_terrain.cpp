@@ -0,0 +1,88 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+
+#include "Base64.h"
+#include "INIFile.h"
+#include "MapReader.h"
+#include "TerrainGrid.h"
+#include "TheaterCache.h"
+#include "WorkQueue.h"
+#include "Exception.h"
+#include "Utils.h"
+#include <stdio.h>
+#include <algorithm>
+
+/* Passability summary for each map, the maps are spread over all the
+ * processors and the reports printed in the order given
+ */
+struct TerrainTask : public WorkQueue::Task {
+	TheaterCache& theaters;
+	char** maps;
+	std::vector<std::string> reports;
+	TerrainTask(TheaterCache& t, char** m, size_t n) : theaters(t), maps(m), reports(n) { }
+	void run(size_t n) {
+		try {
+			reports[n] = report(maps[n]);
+		} catch(Exception& e) {
+			reports[n] = std::string(maps[n]) + ": " + e.what() + "\n";
+		}
+	}
+	std::string report(char const* file) {
+		size_t len, unpackedLen;
+		INIFile ini(file, true);
+		ini.setCurrentSection("Map");
+		Theater const& theater = theaters.get(ini.getKey("Theater"));
+		ini.setCurrentSection("IsoMapPack5");
+		Utils::ScopedArray<uint8_t> data(Base64::decode(ini, len));
+		Utils::ScopedArray<uint8_t> unpacked(MapReader::unpack(data.ptr, len, unpackedLen, MapReader::LZOPack, 1));
+		MapReader map;
+		map.readIsoMapPack(unpacked.ptr, unpackedLen);
+		TerrainGrid grid(map, theater);
+
+		std::vector<uint32_t> labels, landSizes, navalSizes;
+		uint32_t landRegions = grid.labelRegions(TerrainGrid::Land, labels, landSizes);
+		uint32_t navalRegions = grid.labelRegions(TerrainGrid::Naval, labels, navalSizes);
+		uint32_t largestLand = landSizes.empty() ? 0 : *std::max_element(landSizes.begin(), landSizes.end());
+		uint32_t largestNaval = navalSizes.empty() ? 0 : *std::max_element(navalSizes.begin(), navalSizes.end());
+
+		char line[512];
+		snprintf(line, sizeof(line), "%s: %u cells, %u land in %u regions (largest %u), %u water in %u regions (largest %u), %u ramps\n",
+			file, grid.countCells(TerrainGrid::Present),
+			grid.countCells(TerrainGrid::Land), landRegions, largestLand,
+			grid.countCells(TerrainGrid::Naval), navalRegions, largestNaval,
+			grid.countCells(TerrainGrid::Ramp));
+		return line;
+	}
+};
+
+int main(int argc, char** argv) {
+	if(argc < 3) {
+		fprintf(stderr, "Usage: (bin) <theater-data-dir> <map-file>...\n");
+		return 1;
+	}
+	TheaterCache theaters(argv[1]);
+	TerrainTask task(theaters, &argv[2], argc - 2);
+	WorkQueue::run(task, argc - 2);
+	for(size_t i = 0; i != task.reports.size(); i++) {
+		fputs(task.reports[i].c_str(), stdout);
+	}
+	return 0;
+}
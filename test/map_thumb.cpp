@@ -0,0 +1,84 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "Base64.h"
+#include "MapReader.h"
+#include "MapRenderer.h"
+#include "TileMips.h"
+#include "Theater.h"
+#include "Palette.h"
+#include "WorkQueue.h"
+#include "Exception.h"
+#include "Utils.h"
+#include "SDLUtils.h"
+#include <SDL/SDL.h>
+#include <stdlib.h>
+#include <sstream>
+
+/* Each map is rendered on a single thread, the maps themselves are spread
+ * over all the processors
+ */
+struct ThumbnailTask : public WorkQueue::Task {
+	Theater const& theater;
+	TileMips const& mips;
+	unsigned int level;
+	char** maps;
+	ThumbnailTask(Theater const& t, TileMips const& m, unsigned int l, char** f) :
+		theater(t), mips(m), level(l), maps(f) { }
+	void run(size_t n) {
+		size_t len, unpackedLen;
+		INIFile ini(maps[n], true);
+		ini.setCurrentSection("IsoMapPack5");
+		uint8_t* data = Base64::decode(ini, len);
+		Utils::ScopedArray<uint8_t> data_free(data);
+		uint8_t* unpacked = MapReader::unpack(data, len, unpackedLen, MapReader::LZOPack, 1);
+		Utils::ScopedArray<uint8_t> unpacked_free(unpacked);
+		MapReader map;
+		map.readIsoMapPack(unpacked, unpackedLen);
+		MapRenderer renderer(map, theater);
+
+		uint32_t w, h;
+		renderer.getThumbnailSize(level, w, h);
+		uint8_t* rgba = new uint8_t[w * h * 4];
+		Utils::ScopedArray<uint8_t> rgba_free(rgba);
+		renderer.renderThumbnail(rgba, mips, level, 1);
+		SDL_Surface* img = SDL_CreateRGBSurfaceFrom(rgba, w, h, 32, w * 4, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+		if(img == NULL) {
+			throw EXCEPTION("Could not create %u x %u surface", w, h);
+		}
+		SDL::ScopedSurface img_free(img);
+		std::ostringstream fname;
+		fname << maps[n] << "-thumb.bmp";
+		SDL_SaveBMP(img, fname.str().c_str());
+	}
+};
+
+int main(int argc, char** argv) {
+	if(argc < 7) {
+		fprintf(stderr, "Usage: (bin) <theater-ini> <tile-dir> <tile-ext> <pal-file> <level 1-3> <map-file>...\n");
+		return 1;
+	}
+	Theater theater(argv[1], argv[2], argv[3]);
+	Palette pal(argv[4]);
+	TileMips mips(theater, pal);
+	ThumbnailTask task(theater, mips, atoi(argv[5]), &argv[6]);
+	WorkQueue::run(task, argc - 6);
+	return 0;
+}
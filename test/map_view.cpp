@@ -0,0 +1,140 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "Base64.h"
+#include "MapReader.h"
+#include "MapRenderer.h"
+#include "MapChunkCache.h"
+#include "Theater.h"
+#include "Palette.h"
+#include "Display.h"
+#include "Input.h"
+#include "SDLUtils.h"
+#include "Utils.h"
+#include <SDL/SDL.h>
+#include <vector>
+
+class MapViewer : public Input {
+protected:
+	MapChunkCache& cache;
+	uint32_t colour[256];
+	std::vector<uint8_t> view;
+	float pos[2], posRate[2];
+public:
+	MapViewer(MapChunkCache& c, Palette const& pal) : cache(c), view(Display::resX * Display::resY) {
+		SDL_Surface* screen = Display::getScreen();
+		uint8_t r, g, b;
+		for(unsigned int i = 0; i != 256; i++) {
+			pal.getRGB(i, r, g, b);
+			colour[i] = SDL_MapRGB(screen->format, r, g, b);
+		}
+		pos[0] = pos[1] = 0;
+		posRate[0] = posRate[1] = 0;
+		framePeriod = 1000 / 60;
+	}
+	virtual ~MapViewer() { }
+
+	virtual int main() {
+		pos[0] += posRate[0] * frameDelta / 1000;
+		pos[1] += posRate[1] * frameDelta / 1000;
+		cache.renderViewport(&view[0], Display::resX, static_cast<int32_t>(pos[0]), static_cast<int32_t>(pos[1]),
+			Display::resX, Display::resY);
+		SDL_Surface* screen = Display::getScreen();
+		{
+			SDL::ScopedSurfaceLock lock(screen);
+			for(unsigned int y = 0; y != Display::resY; y++) {
+				uint32_t* px = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(screen->pixels) + y * screen->pitch);
+				uint8_t const* in = &view[y * Display::resX];
+				for(unsigned int x = 0; x != Display::resX; x++) {
+					px[x] = colour[in[x]];
+				}
+			}
+		}
+		Display::flip();
+		return 0;
+	}
+	virtual void inputKeyDown(SDLKey key, SDLMod mod) {
+		switch(key) {
+			case SDLK_UP:
+				posRate[1] = -800;
+			break;
+			case SDLK_DOWN:
+				posRate[1] = 800;
+			break;
+			case SDLK_LEFT:
+				posRate[0] = -800;
+			break;
+			case SDLK_RIGHT:
+				posRate[0] = 800;
+			break;
+			default:
+			break;
+		}
+	}
+	virtual void inputKeyUp(SDLKey key, SDLMod mod) {
+		switch(key) {
+			case SDLK_UP:
+			case SDLK_DOWN:
+				posRate[1] = 0;
+			break;
+			case SDLK_LEFT:
+			case SDLK_RIGHT:
+				posRate[0] = 0;
+			break;
+			case SDLK_SPACE:
+				cache.print();
+			break;
+			default:
+			break;
+		}
+	}
+	virtual void inputMouseMove(uint8_t button, unsigned int, unsigned int, int xrel, int yrel) {
+		if(button & SDL_BUTTON(1)) {
+			pos[0] -= xrel;
+			pos[1] -= yrel;
+		}
+	}
+};
+
+int main(int argc, char** argv) {
+	if(argc < 6) {
+		fprintf(stderr, "Usage: (bin) <map-file> <theater-ini> <tile-dir> <tile-ext> <pal-file> [<cache-MB>]\n");
+		return 1;
+	}
+	size_t len, unpackedLen;
+	INIFile ini(argv[1], true);
+	ini.setCurrentSection("IsoMapPack5");
+	uint8_t* data = Base64::decode(ini, len);
+	Utils::ScopedArray<uint8_t> data_free(data);
+	uint8_t* unpacked = MapReader::unpack(data, len, unpackedLen, MapReader::LZOPack);
+	Utils::ScopedArray<uint8_t> unpacked_free(unpacked);
+
+	MapReader map;
+	map.readIsoMapPack(unpacked, unpackedLen);
+	Theater theater(argv[2], argv[3], argv[4]);
+	Palette pal(argv[5]);
+	MapRenderer renderer(map, theater);
+	MapChunkCache cache(renderer, 256, argc > 6 ? atoi(argv[6]) << 20 : 64 << 20);
+
+	Display::activeImplementation = IMPL_SDL;
+	MapViewer viewer(cache, pal);
+	viewer.run();
+	return 0;
+}
@@ -19,6 +19,7 @@
 
 #include "VXLFile.h"
 #include "HVAFile.h"
+#include <math.h>
 #include <sstream>
 #include <SDL/SDL.h>
 #include <SDL/SDL_opengl.h>
@@ -85,9 +86,9 @@ public:
 		if(hva && animRun) {
 			frame += frameRate * fp;
 			if(frame >= (float)hva->numFrames()) {
-				frame = 0;
+				frame = fmodf(frame, (float)hva->numFrames());
 			}
-			renderer.frame = static_cast<unsigned int>(frame);
+			renderer.frame = frame;
 		}
 
 		glLoadIdentity();
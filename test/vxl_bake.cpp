@@ -0,0 +1,142 @@
+/*
+ * Part of the Red Alert 2 File Format Tools.
+ * Copyright (C) 2008 Thomas Spurden <thomasspurden@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "BakedModel.h"
+#include "VXLFile.h"
+#include "HVAFile.h"
+#include "Exception.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <vector>
+
+/* Bakes a VXL with its HVA, checks every baked transform against working it
+ * out live the way VoxelRenderer does and that every voxel centre falls in
+ * its frame's bounding box, then compares the cost of a frame both ways
+ */
+
+namespace {
+	double now() {
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+	}
+
+	/* One frame's limb transforms, worked out from scratch */
+	void liveTransforms(VXLFile& vxl, HVAFile& hva, std::vector<uint32_t> const& binding, float time,
+			std::vector<float>& sampled, float* out) {
+		hva.sampleAll(time, &sampled[0]);
+		for(uint32_t i = 0; i != vxl.getNumLimbs(); i++, out += 16) {
+			vxl.setCurrentLimb(i);
+			uint8_t xs, ys, zs;
+			float min[3], max[3];
+			vxl.getSize(xs, ys, zs);
+			vxl.getBounds(min, max);
+			float scale[3] = { (max[0] - min[0]) / xs, (max[1] - min[1]) / ys, (max[2] - min[2]) / zs };
+			float const* m = &sampled[binding[i] * 16];
+			for(int e = 0; e != 12; e++) {
+				out[e] = m[e];
+			}
+			float t[3];
+			for(int a = 0; a != 3; a++) {
+				t[a] = m[12 + a] * vxl.getScale() * scale[a];
+			}
+			for(int a = 0; a != 3; a++) {
+				out[12 + a] = m[a] * min[0] + m[4 + a] * min[1] + m[8 + a] * min[2] + t[a];
+			}
+			out[15] = 1;
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	if(argc < 3) {
+		fprintf(stderr, "Usage: (bin) <vxl-file> <hva-file> [<steps-per-frame>]\n");
+		return 1;
+	}
+	VXLFile vxl(argv[1]);
+	HVAFile hva(argv[2]);
+	uint32_t steps = (argc > 3) ? atoi(argv[3]) : 1;
+
+	double start = now();
+	BakedModel baked(vxl, &hva, steps, true);
+	double bakeTime = now() - start;
+	uint32_t limbs = baked.numLimbs();
+	printf("Baked %u frames of %u limbs in %.2f ms, %lu bytes\n", baked.numFrames(), limbs, bakeTime, baked.bakedSize());
+
+	std::vector<uint32_t> binding;
+	for(uint32_t i = 0; i != limbs; i++) {
+		vxl.setCurrentLimb(i);
+		binding.push_back(hva.findSection(vxl.limbName()));
+	}
+	std::vector<float> sampled(hva.numSections() * 16), live(limbs * 16);
+
+	float transformErr = 0;
+	size_t outside = 0;
+	for(uint32_t f = 0; f != baked.numFrames(); f++) {
+		float time = static_cast<float>(f) / static_cast<float>(steps);
+		if(baked.getFrame(time) != f) {
+			fprintf(stderr, "Time %f maps to frame %u, not %u\n", time, baked.getFrame(time), f);
+			return 1;
+		}
+		liveTransforms(vxl, hva, binding, time, sampled, &live[0]);
+		float const* b = baked.getBounds(f);
+		for(uint32_t i = 0; i != limbs; i++) {
+			float const* m = baked.getTransform(f, i);
+			for(int e = 0; e != 16; e++) {
+				transformErr = fmaxf(transformErr, fabsf(m[e] - live[i * 16 + e]));
+			}
+			size_t n;
+			baked.getVoxels(i, n);
+			float const* c = baked.getCentres(f, i);
+			for(size_t v = 0; v != n; v++, c += 3) {
+				for(int a = 0; a != 3; a++) {
+					if(c[a] < b[a] || c[a] > b[a + 3]) {
+						outside++;
+						break;
+					}
+				}
+			}
+		}
+		printf("Frame %3u: (% 8.02f, % 8.02f, % 8.02f) -> (% 8.02f, % 8.02f, % 8.02f)\n", f, b[0], b[1], b[2], b[3], b[4], b[5]);
+	}
+	printf("Transform error %g, %lu voxel centres outside their bounds\n", transformErr, outside);
+
+	unsigned int const reps = 100000;
+	volatile float sink = 0;
+	start = now();
+	for(unsigned int r = 0; r != reps; r++) {
+		liveTransforms(vxl, hva, binding, static_cast<float>(r) * 0.37f, sampled, &live[0]);
+		sink += live[12];
+	}
+	double liveTime = now() - start;
+	start = now();
+	for(unsigned int r = 0; r != reps; r++) {
+		uint32_t f = baked.getFrame(static_cast<float>(r) * 0.37f);
+		for(uint32_t i = 0; i != limbs; i++) {
+			sink += baked.getTransform(f, i)[12];
+		}
+		sink += baked.getBounds(f)[0];
+	}
+	double bakedTime = now() - start;
+	printf("Per frame: live %.1f ns, baked %.1f ns\n", liveTime * 1e6 / reps, bakedTime * 1e6 / reps);
+	return (transformErr < 1e-3f && outside == 0) ? 0 : 1;
+}